@@ -0,0 +1,104 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_benchmark.hpp"
+
+#include <fstream>
+
+using namespace vtu11;
+
+namespace
+{
+
+// Discards everything, measures only the cost of pushing data through the stream
+struct NullBuffer : public std::streambuf
+{
+    int overflow( int c ) override { return c; }
+    std::streamsize xsputn( const char*, std::streamsize n ) override { return n; }
+};
+
+// Previous implementation, writing one char after the other
+void writeCharwise( std::ostream& output, const RawBinaryAppendedWriter& writer )
+{
+    for( const auto& dataSet : writer.appendedData )
+    {
+        HeaderType header = dataSet.numberOfBytes;
+
+        const char* headerBegin = reinterpret_cast<const char*>( &header );
+        const char* dataBegin = reinterpret_cast<const char*>( dataSet.data );
+
+        for( const char* ptr = headerBegin; ptr < headerBegin + sizeof( HeaderType ); ++ptr )
+        {
+            output << *ptr;
+        }
+
+        for( const char* ptr = dataBegin; ptr < dataBegin + dataSet.numberOfBytes; ++ptr )
+        {
+            output << *ptr;
+        }
+    }
+}
+
+} // namespace
+
+// Usage: appended_benchmark [number of MB] [file for writing to disk]
+int main( int argc, char** argv )
+{
+    size_t megaBytes = argc > 1 ? std::stoul( argv[1] ) : 1024;
+
+    std::vector<double> data( megaBytes * 1024 * 1024 / sizeof( double ), 1.0 );
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream( &nullBuffer );
+
+    RawBinaryAppendedWriter writer;
+
+    writer.writeData( nullStream, data );
+
+    size_t numberOfBytes = writer.offset;
+
+    auto run = [&]( const std::string& name, std::ostream& output )
+    {
+        double charwise = vtu11benchmark::measure( [&]( ){ writeCharwise( output, writer ); }, 3 );
+
+        vtu11benchmark::report( name + " charwise", numberOfBytes, charwise );
+
+        double bulk = vtu11benchmark::measure( [&]( ){ writer.writeAppended( output ); }, 3 );
+
+        vtu11benchmark::report( name + " bulk", numberOfBytes, bulk );
+    };
+
+    run( "null stream", nullStream );
+
+    if( argc > 2 )
+    {
+        std::ofstream file( argv[2], std::ios::binary );
+
+        std::vector<char> buffer( 32 * 1024 );
+
+        file.rdbuf( )->pubsetbuf( buffer.data( ), static_cast<std::streamsize>( buffer.size( ) ) );
+
+        run( "file", file );
+
+        // Concurrent pwrite calls into the presized file
+        for( size_t numberOfThreads : std::vector<size_t> { 2, 4, 8 } )
+        {
+            writer.numberOfThreads = numberOfThreads;
+
+            double pwrite = vtu11benchmark::measure( [&]( )
+            { 
+                file.seekp( 0 );
+                writer.writeAppended( file, argv[2] ); 
+            }, 3 );
+
+            vtu11benchmark::report( "file pwrite " + std::to_string( numberOfThreads ) + " threads", numberOfBytes, pwrite );
+        }
+    }
+}
@@ -0,0 +1,128 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_benchmark.hpp"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+using namespace vtu11;
+
+namespace
+{
+
+// Discards everything, measures only formatting and pushing data through the stream
+struct NullBuffer : public std::streambuf
+{
+    int overflow( int c ) override { return c; }
+    std::streamsize xsputn( const char*, std::streamsize n ) override { return n; }
+};
+
+// Previous implementation, formatting one value with snprintf
+void writeNumber( char (&buffer)[64], double value )
+{
+    std::snprintf( buffer, sizeof( buffer ), VTU11_ASCII_FLOATING_POINT_FORMAT, value );
+}
+
+void writeNumber( char (&buffer)[64], std::int64_t value )
+{
+    std::snprintf( buffer, sizeof( buffer ), "%" PRId64, value );
+}
+
+// Previous implementation, formatting each value with snprintf and writing it with operator<<
+template<typename T>
+void writeSnprintf( std::ostream& output, const std::vector<T>& data )
+{
+    char buffer[64];
+
+    for( auto value : data )
+    {
+        writeNumber( buffer, value );
+
+        output << buffer << " ";
+    }
+
+    output << "\n";
+}
+
+// Previous implementation for cell types
+void writeStream( std::ostream& output, const std::vector<std::int8_t>& data )
+{
+    for( auto value : data )
+    {
+        output << static_cast<int>( value ) << " ";
+    }
+
+    output << "\n";
+}
+
+} // namespace
+
+// Usage: ascii_benchmark [number of values in millions] [number of threads]
+int main( int argc, char** argv )
+{
+    size_t millions = argc > 1 ? std::stoul( argv[1] ) : 4;
+    size_t numberOfThreads = argc > 2 ? std::stoul( argv[2] ) : 0;
+
+    std::vector<double> points( millions * 1000000 );
+
+    for( size_t i = 0; i < points.size( ); ++i )
+    {
+        points[i] = std::sin( static_cast<double>( i ) * 1e-3 ) * static_cast<double>( i % 1000 );
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream output( &nullBuffer );
+
+    AsciiWriter writer, parallelWriter;
+    RoundTripAsciiWriter roundTripWriter;
+    BasicAsciiWriter<SignificantDigits<6>> compileTimeWriter;
+
+    parallelWriter.numberOfThreads = numberOfThreads;
+
+    size_t numberOfBytes = points.size( ) * sizeof( double );
+
+    auto run = [&]( const std::string& name, std::function<void( )> function )
+    {
+        vtu11benchmark::report( name, numberOfBytes, vtu11benchmark::measure( function, 3 ) );
+    };
+
+    run( "double snprintf " VTU11_ASCII_FLOATING_POINT_FORMAT, [&]( ){ writeSnprintf( output, points ); } );
+    run( "double AsciiWriter", [&]( ){ writer.writeData( output, points ); } );
+    run( "double SignificantDigits<6>", [&]( ){ compileTimeWriter.writeData( output, points ); } );
+    run( "double RoundTripAsciiWriter", [&]( ){ roundTripWriter.writeData( output, points ); } );
+    run( "double AsciiWriter " + std::to_string( detail::resolveNumberOfThreads( numberOfThreads ) ) + 
+         " threads", [&]( ){ parallelWriter.writeData( output, points ); } );
+
+    // Connectivity of a large mesh and cell types
+    std::vector<VtkIndexType> connectivity( points.size( ) );
+    std::vector<VtkCellType> types( points.size( ) );
+
+    for( size_t i = 0; i < connectivity.size( ); ++i )
+    {
+        connectivity[i] = static_cast<VtkIndexType>( ( i * 7919 ) % connectivity.size( ) );
+        types[i] = static_cast<VtkCellType>( i % 2 != 0 ? 12 : 10 );
+    }
+
+    numberOfBytes = connectivity.size( ) * sizeof( VtkIndexType );
+
+    run( "int64 snprintf %" PRId64, [&]( ){ writeSnprintf( output, connectivity ); } );
+    run( "int64 AsciiWriter", [&]( ){ writer.writeData( output, connectivity ); } );
+
+    numberOfBytes = types.size( ) * sizeof( VtkCellType );
+
+    run( "int8 operator<<", [&]( ){ writeStream( output, types ); } );
+    run( "int8 AsciiWriter", [&]( ){ writer.writeData( output, types ); } );
+
+    #ifdef VTU11_USE_TO_CHARS
+    std::printf( "(using std::to_chars)\n" );
+    #endif
+}
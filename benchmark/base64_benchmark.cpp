@@ -0,0 +1,58 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/inc/utilities.hpp"
+#include "vtu11_benchmark.hpp"
+
+#include <vector>
+
+using namespace vtu11;
+
+int main( )
+{
+    std::vector<Byte> data( 256 * 1024 * 1024 );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        data[i] = static_cast<Byte>( ( i * 2654435761u ) >> 13 );
+    }
+
+    std::string encoded( encodedNumberOfBytes( data.size( ) ), '\0' );
+
+    const char* names[] = { "scalar", "ssse3", "avx2", "avx512" };
+
+    for( auto isa : { detail::Base64Isa::Scalar, detail::Base64Isa::SSSE3, 
+                      detail::Base64Isa::AVX2, detail::Base64Isa::AVX512 } )
+    {
+        auto name = std::string { "base64 " } + names[static_cast<int>( isa )];
+
+        if( !detail::base64IsaSupported( isa ) )
+        {
+            std::printf( "%-40s not supported\n", name.c_str( ) );
+
+            continue;
+        }
+
+        auto kernel = detail::base64Kernel( isa );
+
+        double seconds = vtu11benchmark::measure( [&]( )
+        { 
+            size_t consumed = kernel( data.data( ), data.size( ), &encoded[0] );
+
+            detail::base64EncodeScalar( data.data( ) + consumed, data.size( ) - consumed, 
+                                        &encoded[encodedNumberOfBytes( consumed )] );
+        } );
+
+        vtu11benchmark::report( name, data.size( ), seconds );
+    }
+
+    double seconds = vtu11benchmark::measure( [&]( ){ encoded = base64Encode( data.begin( ), data.end( ) ); } );
+
+    vtu11benchmark::report( "base64Encode (dispatched)", data.size( ), seconds );
+}
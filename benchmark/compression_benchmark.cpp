@@ -0,0 +1,107 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_benchmark.hpp"
+
+#include <cmath>
+
+using namespace vtu11;
+
+// Usage: compression_benchmark [number of MB] [number of threads]
+int main( int argc, char** argv )
+{
+    size_t megaBytes = argc > 1 ? std::stoul( argv[1] ) : 256;
+    size_t numberOfThreads = argc > 2 ? std::stoul( argv[2] ) : 1;
+
+    // Smooth field with a bit of noise in the lower digits
+    std::vector<double> data( megaBytes * 1024 * 1024 / sizeof( double ) );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        auto x = static_cast<double>( i ) * 1e-4;
+
+        data[i] = std::round( 1e6 * std::sin( x ) * std::cos( 0.3 * x ) ) * 1e-6;
+    }
+
+    size_t numberOfBytes = data.size( ) * sizeof( double );
+
+    #ifdef VTU11_ENABLE_ZLIB
+    for( int level = 0; level <= 9; ++level )
+    {
+        std::vector<Byte> arena;
+        std::vector<HeaderType> header;
+
+        double seconds = vtu11benchmark::measure( [&]( )
+        {
+            arena.clear( );
+            header = detail::zlibCompressData( data, arena, 32768, numberOfThreads, level );
+        }, 3 );
+
+        size_t compressedSize = arena.size( );
+
+        vtu11benchmark::report( "zlib level " + std::to_string( level ), numberOfBytes, 
+                                seconds, vtu11benchmark::ratio( compressedSize, numberOfBytes ) );
+    }
+    #endif
+
+    #ifdef VTU11_ENABLE_LIBDEFLATE
+    for( int level : { 0, 1, 6, 9, 12 } )
+    {
+        std::vector<Byte> arena;
+
+        double seconds = vtu11benchmark::measure( [&]( )
+        {
+            arena.clear( );
+            detail::compressData<LibdeflateCompressor>( data, arena, 32768, numberOfThreads, level );
+        }, 3 );
+
+        size_t compressedSize = arena.size( );
+
+        vtu11benchmark::report( "libdeflate level " + std::to_string( level ), numberOfBytes, 
+                                seconds, vtu11benchmark::ratio( compressedSize, numberOfBytes ) );
+    }
+    #endif
+
+    #ifdef VTU11_ENABLE_LZ4
+    for( int level : { 1, 5, 9 } )
+    {
+        std::vector<Byte> arena;
+
+        double seconds = vtu11benchmark::measure( [&]( )
+        {
+            arena.clear( );
+            detail::compressData<Lz4Compressor>( data, arena, 32768, numberOfThreads, level );
+        }, 3 );
+
+        size_t compressedSize = arena.size( );
+
+        vtu11benchmark::report( "lz4 level " + std::to_string( level ), numberOfBytes, 
+                                seconds, vtu11benchmark::ratio( compressedSize, numberOfBytes ) );
+    }
+    #endif
+
+    #ifdef VTU11_ENABLE_LZMA
+    for( int level : { 0, 6 } )
+    {
+        std::vector<Byte> arena;
+
+        double seconds = vtu11benchmark::measure( [&]( )
+        {
+            arena.clear( );
+            detail::compressData<LzmaCompressor>( data, arena, 1 << 20, numberOfThreads, level );
+        }, 1 );
+
+        size_t compressedSize = arena.size( );
+
+        vtu11benchmark::report( "lzma level " + std::to_string( level ) + " (1 MiB blocks)", numberOfBytes, 
+                                seconds, vtu11benchmark::ratio( compressedSize, numberOfBytes ) );
+    }
+    #endif
+}
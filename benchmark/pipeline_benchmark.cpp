@@ -0,0 +1,169 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_benchmark.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace vtu11;
+
+namespace
+{
+
+// Seekable sink that discards the data and sleeps as if writing to a device with the given bandwidth
+struct ThrottledBuffer : public std::streambuf
+{
+    explicit ThrottledBuffer( double bytesPerSecond ) : 
+        bytesPerSecond_( bytesPerSecond ), position_( 0 ), size_( 0 )
+    { }
+
+    int overflow( int c ) override
+    { 
+        char value = static_cast<char>( c );
+
+        xsputn( &value, 1 );
+
+        return c;
+    }
+
+    std::streamsize xsputn( const char*, std::streamsize n ) override
+    {
+        std::this_thread::sleep_for( std::chrono::duration<double>( static_cast<double>( n ) / bytesPerSecond_ ) );
+
+        position_ += n;
+        size_ = (std::max)( size_, position_ );
+
+        return n;
+    }
+
+    pos_type seekoff( off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode ) override
+    {
+        off_type base = direction == std::ios_base::beg ? 0 : ( direction == std::ios_base::cur ? position_ : size_ );
+
+        position_ = base + offset;
+
+        return position_;
+    }
+
+    pos_type seekpos( pos_type position, std::ios_base::openmode mode ) override
+    {
+        return seekoff( position, std::ios_base::beg, mode );
+    }
+
+private:
+    double bytesPerSecond_;
+    off_type position_, size_;
+};
+
+} // namespace
+
+// Usage: pipeline_benchmark [number of MB] [sink bandwidth in MB/s] [number of threads]
+int main( int argc, char** argv )
+{
+    size_t megaBytes = argc > 1 ? std::stoul( argv[1] ) : 64;
+    double bandwidth = argc > 2 ? std::stod( argv[2] ) : 200.0;
+    size_t numberOfThreads = argc > 3 ? std::stoul( argv[3] ) : 1;
+
+    // Smooth field with a bit of noise in the lower digits, split into several arrays
+    size_t numberOfArrays = 8;
+
+    std::vector<std::vector<double>> arrays( numberOfArrays );
+
+    for( size_t iArray = 0; iArray < numberOfArrays; ++iArray )
+    {
+        arrays[iArray].resize( megaBytes * 1024 * 1024 / sizeof( double ) / numberOfArrays );
+
+        for( size_t i = 0; i < arrays[iArray].size( ); ++i )
+        {
+            auto x = static_cast<double>( i + iArray ) * 1e-4;
+
+            arrays[iArray][i] = std::round( 1e6 * std::sin( x ) * std::cos( 0.3 * x ) ) * 1e-6;
+        }
+    }
+
+    size_t numberOfBytes = numberOfArrays * arrays[0].size( ) * sizeof( double );
+
+    #ifdef VTU11_ENABLE_ZLIB
+    ThrottledBuffer buffer( bandwidth * 1024.0 * 1024.0 );
+    std::ostream output( &buffer );
+
+    auto write = [&]( bool pipelined, size_t& compressedSize )
+    {
+        StreamingCompressedRawBinaryAppendedWriter writer;
+
+        writer.numberOfThreads = numberOfThreads;
+        writer.pipelined = pipelined;
+
+        output.seekp( 0 );
+
+        for( const auto& array : arrays )
+        {
+            auto attributes = StringStringMap { { "type", "Float64" } };
+
+            writer.addDataAttributes( attributes );
+
+            output << "<DataArray offset=\"" << attributes["offset"] << "\"/>\n";
+
+            writer.writeData( output, array );
+        }
+
+        output << "_";
+
+        writer.writeAppended( output );
+
+        compressedSize = 0;
+
+        for( const auto& statistics : writer.statistics )
+        {
+            compressedSize += statistics.compressedNumberOfBytes;
+        }
+    };
+
+    size_t compressedSize = 0;
+
+    // Lower bounds: compression alone and writing the compressed size alone
+    double compress = vtu11benchmark::measure( [&]( )
+    { 
+        std::vector<Byte> arena;
+
+        for( const auto& array : arrays )
+        {
+            arena.clear( );
+
+            detail::zlibCompressData( array, arena, 32768, numberOfThreads );
+        }
+    }, 3 );
+
+    write( false, compressedSize );
+
+    double sink = vtu11benchmark::measure( [&]( )
+    {
+        std::vector<char> bytes( compressedSize );
+
+        output.write( bytes.data( ), static_cast<std::streamsize>( bytes.size( ) ) );
+    }, 3 );
+
+    double serial = vtu11benchmark::measure( [&]( ){ write( false, compressedSize ); }, 3 );
+    double pipelined = vtu11benchmark::measure( [&]( ){ write( true, compressedSize ); }, 3 );
+
+    auto ratio = vtu11benchmark::ratio( compressedSize, numberOfBytes );
+
+    vtu11benchmark::report( "compress only", numberOfBytes, compress );
+    vtu11benchmark::report( "throttled write only", numberOfBytes, sink, ratio );
+    vtu11benchmark::report( "streaming serial", numberOfBytes, serial, ratio );
+    vtu11benchmark::report( "streaming pipelined", numberOfBytes, pipelined, ratio );
+    #else
+    static_cast<void>( bandwidth );
+    static_cast<void>( numberOfThreads );
+    static_cast<void>( numberOfBytes );
+    #endif
+}
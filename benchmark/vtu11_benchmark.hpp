@@ -0,0 +1,55 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_BENCHMARK_HPP
+#define VTU11_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace vtu11benchmark
+{
+
+//! Returns the minimum wall time in seconds over the given number of repetitions
+template<typename Function> inline
+double measure( Function&& function, size_t repetitions = 5 )
+{
+    double best = 0.0;
+
+    for( size_t i = 0; i < repetitions; ++i )
+    {
+        auto start = std::chrono::steady_clock::now( );
+
+        function( );
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now( ) - start;
+
+        best = ( i == 0 || elapsed.count( ) < best ) ? elapsed.count( ) : best;
+    }
+
+    return best;
+}
+
+//! Prints time and throughput with an optional comment at the end
+inline void report( const std::string& name, size_t numberOfBytes, double seconds, 
+                    const std::string& comment = "" )
+{
+    std::printf( "%-40s %10.3f ms %10.3f GB/s   %s\n", name.c_str( ), seconds * 1e3, 
+                 static_cast<double>( numberOfBytes ) / seconds * 1e-9, comment.c_str( ) );
+}
+
+inline std::string ratio( size_t compressedSize, size_t numberOfBytes )
+{
+    return "ratio " + std::to_string( static_cast<double>( compressedSize ) / static_cast<double>( numberOfBytes ) );
+}
+
+} // namespace vtu11benchmark
+
+#endif // VTU11_BENCHMARK_HPP
@@ -0,0 +1,29 @@
+#          __        ____ ____
+# ___  ___/  |_ __ _/_   /_   |
+# \  \/ /\   __\  |  \   ||   |
+#  \   /  |  | |  |  /   ||   |
+#   \_/   |__| |____/|___||___|
+#
+#  License: BSD License ; see LICENSE
+#
+
+# Finds the LZ4 library and creates the LZ4::LZ4 imported target
+
+find_path( LZ4_INCLUDE_DIR NAMES lz4.h )
+find_library( LZ4_LIBRARY NAMES lz4 liblz4 )
+
+include( FindPackageHandleStandardArgs )
+
+find_package_handle_standard_args( LZ4 REQUIRED_VARS LZ4_LIBRARY LZ4_INCLUDE_DIR )
+
+if( LZ4_FOUND AND NOT TARGET LZ4::LZ4 )
+
+    add_library( LZ4::LZ4 UNKNOWN IMPORTED )
+
+    set_target_properties( LZ4::LZ4 PROPERTIES
+                           IMPORTED_LOCATION "${LZ4_LIBRARY}"
+                           INTERFACE_INCLUDE_DIRECTORIES "${LZ4_INCLUDE_DIR}" )
+
+endif( LZ4_FOUND AND NOT TARGET LZ4::LZ4 )
+
+mark_as_advanced( LZ4_INCLUDE_DIR LZ4_LIBRARY )
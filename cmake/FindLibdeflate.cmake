@@ -0,0 +1,29 @@
+#          __        ____ ____
+# ___  ___/  |_ __ _/_   /_   |
+# \  \/ /\   __\  |  \   ||   |
+#  \   /  |  | |  |  /   ||   |
+#   \_/   |__| |____/|___||___|
+#
+#  License: BSD License ; see LICENSE
+#
+
+# Finds the libdeflate library and creates the Libdeflate::Libdeflate imported target
+
+find_path( Libdeflate_INCLUDE_DIR NAMES libdeflate.h )
+find_library( Libdeflate_LIBRARY NAMES deflate libdeflate )
+
+include( FindPackageHandleStandardArgs )
+
+find_package_handle_standard_args( Libdeflate REQUIRED_VARS Libdeflate_LIBRARY Libdeflate_INCLUDE_DIR )
+
+if( Libdeflate_FOUND AND NOT TARGET Libdeflate::Libdeflate )
+
+    add_library( Libdeflate::Libdeflate UNKNOWN IMPORTED )
+
+    set_target_properties( Libdeflate::Libdeflate PROPERTIES
+                           IMPORTED_LOCATION "${Libdeflate_LIBRARY}"
+                           INTERFACE_INCLUDE_DIRECTORIES "${Libdeflate_INCLUDE_DIR}" )
+
+endif( Libdeflate_FOUND AND NOT TARGET Libdeflate::Libdeflate )
+
+mark_as_advanced( Libdeflate_INCLUDE_DIR Libdeflate_LIBRARY )
@@ -22,13 +22,21 @@ case ${cppversion} in
 esac
 
 InclusionOrder+=("inc/alias.hpp"
-                 "inc/writer.hpp"
                  "inc/utilities.hpp"
+                 "inc/writer.hpp"
+                 "inc/compressedWriter.hpp"
                  "inc/zlibWriter.hpp"
+                 "inc/lz4Writer.hpp"
+                 "inc/lzmaWriter.hpp"
+                 "inc/libdeflateWriter.hpp"
                  "vtu11.hpp"
                  "impl/utilities_impl.hpp"
                  "impl/writer_impl.hpp"
+                 "impl/compressedWriter_impl.hpp"
                  "impl/zlibWriter_impl.hpp"
+                 "impl/lz4Writer_impl.hpp"
+                 "impl/lzmaWriter_impl.hpp"
+                 "impl/libdeflateWriter_impl.hpp"
                  "impl/vtu11_impl.hpp")
 
 echo "//          __        ____ ____        " > ${Single}
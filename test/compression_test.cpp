@@ -0,0 +1,1524 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_testing.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace vtu11
+{
+namespace
+{
+
+template<typename T>
+std::vector<Byte> bytes( const std::vector<T>& data )
+{
+    auto begin = reinterpret_cast<const Byte*>( data.data( ) );
+
+    return std::vector<Byte>( begin, begin + data.size( ) * sizeof( T ) );
+}
+
+// Bytes of data converted to Target values
+template<typename Target, typename T>
+std::vector<Byte> convertedBytes( const std::vector<T>& data )
+{
+    std::vector<Target> converted( data.size( ) );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        converted[i] = static_cast<Target>( data[i] );
+    }
+
+    return bytes( converted );
+}
+
+// Decompresses one array starting with the header [#blocks, block size, last block size, compressed sizes...]
+template<typename Decompress>
+std::vector<Byte> decompressArray( const Byte* data, Decompress&& decompress )
+{
+    HeaderType header[3];
+
+    std::copy( data, data + sizeof( header ), reinterpret_cast<Byte*>( header ) );
+
+    std::vector<HeaderType> compressedSizes( header[0] );
+
+    std::copy( data + sizeof( header ), data + sizeof( header ) + header[0] * sizeof( HeaderType ),
+               reinterpret_cast<Byte*>( compressedSizes.data( ) ) );
+
+    data += ( 3 + header[0] ) * sizeof( HeaderType );
+
+    std::vector<Byte> array( header[0] != 0 ? ( header[0] - 1 ) * header[1] + header[2] : 0 );
+
+    for( size_t iBlock = 0; iBlock < header[0]; ++iBlock )
+    {
+        size_t length = iBlock + 1 < header[0] ? header[1] : header[2];
+
+        REQUIRE( decompress( data, compressedSizes[iBlock], array.data( ) + iBlock * header[1], length ) );
+
+        data += compressedSizes[iBlock];
+    }
+
+    return array;
+}
+
+/* 
+ * Reads the arrays from appended compressed data the same way vtk does: 
+ * offsets are relative to the first char after '_', each array starts with 
+ * the header [#blocks, block size, last block size, compressed sizes...].
+ */
+template<typename Decompress>
+std::vector<std::vector<Byte>> readCompressedAppendedArrays( const std::string& filename, Decompress&& decompress )
+{
+    std::ifstream file( filename, std::ios::binary );
+    std::string content( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>( ) );
+
+    size_t appendedBegin = content.find( '_', content.find( "<AppendedData" ) ) + 1;
+
+    std::vector<std::vector<Byte>> arrays;
+
+    for( size_t position = content.find( "offset=\"" ); position < appendedBegin;
+                position = content.find( "offset=\"", position + 1 ) )
+    {
+        auto offset = std::stoul( content.substr( position + 8 ) );
+        auto data = reinterpret_cast<const Byte*>( content.data( ) ) + appendedBegin + offset;
+
+        arrays.push_back( decompressArray( data, decompress ) );
+    }
+
+    return arrays;
+}
+
+std::vector<Byte> base64Decode( const char* begin, size_t numberOfChars )
+{
+    const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::vector<Byte> decoded;
+
+    for( size_t i = 0; i + 4 <= numberOfChars; i += 4 )
+    {
+        size_t word = 0, numberOfPaddingChars = 0;
+
+        for( size_t j = 0; j < 4; ++j )
+        {
+            auto index = begin[i + j] != '=' ? chars.find( begin[i + j] ) : ( ++numberOfPaddingChars, 0 );
+
+            REQUIRE( index != std::string::npos );
+
+            word = ( word << 6 ) | index;
+        }
+
+        for( size_t j = 0; j < 3 - numberOfPaddingChars; ++j )
+        {
+            decoded.push_back( static_cast<Byte>( word >> ( 16 - 8 * j ) ) );
+        }
+    }
+
+    return decoded;
+}
+
+// Decodes the separately encoded header and compressed blocks into one raw array 
+template<typename Decompress>
+std::vector<Byte> decompressBase64Array( const char* data, Decompress&& decompress )
+{
+    auto firstWords = base64Decode( data, encodedNumberOfBytes( 3 * sizeof( HeaderType ) ) );
+
+    HeaderType numberOfBlocks;
+
+    std::copy( firstWords.begin( ), firstWords.begin( ) + sizeof( HeaderType ), reinterpret_cast<Byte*>( &numberOfBlocks ) );
+
+    size_t numberOfHeaderChars = encodedNumberOfBytes( ( 3 + numberOfBlocks ) * sizeof( HeaderType ) );
+
+    auto raw = base64Decode( data, numberOfHeaderChars );
+
+    size_t numberOfCompressedBytes = 0;
+
+    for( size_t iBlock = 0; iBlock < numberOfBlocks; ++iBlock )
+    {
+        HeaderType compressedSize;
+
+        std::copy( raw.begin( ) + static_cast<std::ptrdiff_t>( ( 3 + iBlock ) * sizeof( HeaderType ) ), 
+                   raw.begin( ) + static_cast<std::ptrdiff_t>( ( 4 + iBlock ) * sizeof( HeaderType ) ),
+                   reinterpret_cast<Byte*>( &compressedSize ) );
+
+        numberOfCompressedBytes += compressedSize;
+    }
+
+    auto blocks = base64Decode( data + numberOfHeaderChars, encodedNumberOfBytes( numberOfCompressedBytes ) );
+
+    raw.insert( raw.end( ), blocks.begin( ), blocks.end( ) );
+
+    return decompressArray( raw.data( ), decompress );
+}
+
+// Reads the arrays of either inline or appended compressed base64 data
+template<typename Decompress>
+std::vector<std::vector<Byte>> readCompressedBase64Arrays( const std::string& filename, Decompress&& decompress )
+{
+    std::string content = vtu11testing::readFile( filename );
+
+    std::vector<std::vector<Byte>> arrays;
+
+    if( content.find( "<AppendedData" ) != std::string::npos )
+    {
+        size_t appendedBegin = content.find( '_', content.find( "<AppendedData" ) ) + 1;
+
+        for( size_t position = content.find( "offset=\"" ); position < appendedBegin;
+                    position = content.find( "offset=\"", position + 1 ) )
+        {
+            auto offset = std::stoul( content.substr( position + 8 ) );
+
+            arrays.push_back( decompressBase64Array( content.data( ) + appendedBegin + offset, decompress ) );
+        }
+    }
+    else
+    {
+        for( size_t position = content.find( "format=\"binary\"" ); position != std::string::npos;
+                    position = content.find( "format=\"binary\"", position + 1 ) )
+        {
+            size_t begin = content.find_first_not_of( " \n", content.find( '>', position ) + 1 );
+
+            arrays.push_back( decompressBase64Array( content.data( ) + begin, decompress ) );
+        }
+    }
+
+    return arrays;
+}
+
+// n x n grid of quads on the unit square
+struct QuadGrid
+{
+    QuadGrid( size_t n = 40 ) : types( n * n, 9 )
+    {
+        for( size_t i = 0; i <= n; ++i )
+        {
+            for( size_t j = 0; j <= n; ++j )
+            {
+                points.insert( points.end( ), { i / static_cast<double>( n ), j / static_cast<double>( n ), 0.0 } );
+                pointData.push_back( static_cast<double>( i * j ) );
+            }
+        }
+
+        for( size_t i = 0; i < n; ++i )
+        {
+            for( size_t j = 0; j < n; ++j )
+            {
+                auto index = static_cast<VtkIndexType>( i * ( n + 1 ) + j );
+                auto nextRow = static_cast<VtkIndexType>( n + 1 );
+
+                connectivity.insert( connectivity.end( ), { index, index + nextRow, index + nextRow + 1, index + 1 } );
+                offsets.push_back( static_cast<VtkIndexType>( connectivity.size( ) ) );
+            }
+        }
+    }
+
+    Vtu11UnstructuredMesh mesh( )
+    {
+        return { points, connectivity, offsets, types };
+    }
+
+    // In the order of writing
+    std::vector<std::vector<Byte>> arrays( ) const
+    {
+        return { bytes( pointData ), bytes( points ), bytes( connectivity ), bytes( offsets ), bytes( types ) };
+    }
+
+    std::vector<DataSetInfo> dataSetInfo { { "pointData", DataSetType::PointData, 1 } };
+
+    std::vector<double> points, pointData;
+    std::vector<VtkIndexType> connectivity, offsets;
+    std::vector<VtkCellType> types;
+};
+
+// User-provided compressor that copies the blocks
+struct CopyCompressor
+{
+    static const char* name( ) { return "vtkCopyDataCompressor"; }
+
+    static constexpr int defaultLevel = 1;
+    static constexpr int fastLevel = 1;
+    static constexpr int storeLevel = 0;
+
+    explicit CopyCompressor( int ) { }
+
+    static size_t compressBound( size_t numberOfBytes ) { return numberOfBytes; }
+
+    size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t )
+    {
+        std::memcpy( target, source, numberOfBytes );
+
+        return numberOfBytes;
+    }
+};
+
+// Counts the compressed blocks, including the sample blocks of adaptive compression
+struct CountingCompressor final : CopyCompressor
+{
+    explicit CountingCompressor( int level ) : CopyCompressor( level ) { }
+
+    size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity )
+    {
+        numberOfCalls += 1;
+
+        return CopyCompressor::compress( source, numberOfBytes, target, capacity );
+    }
+
+    static size_t numberOfCalls;
+};
+
+size_t CountingCompressor::numberOfCalls = 0;
+
+bool copyDecompress( const Byte* source, size_t numberOfBytes, Byte* target, size_t expectedSize )
+{
+    std::memcpy( target, source, numberOfBytes );
+
+    return numberOfBytes == expectedSize;
+}
+
+// Accepts all chars but cannot seek, like a pipe
+struct NonSeekableBuffer : std::streambuf
+{
+    int overflow( int c ) override
+    {
+        return traits_type::not_eof( c );
+    }
+};
+
+// Seekable buffer that fails all writes after the first numberOfWrites, like a full disk
+struct FailingBuffer : std::stringbuf
+{
+    explicit FailingBuffer( size_t numberOfWrites ) : numberOfWrites_( numberOfWrites ) { }
+
+    std::streamsize xsputn( const char* data, std::streamsize numberOfChars ) override
+    {
+        return fail( ) ? 0 : std::stringbuf::xsputn( data, numberOfChars );
+    }
+
+    int overflow( int c ) override
+    {
+        return fail( ) ? traits_type::eof( ) : std::stringbuf::overflow( c );
+    }
+
+    bool fail( )
+    {
+        if( numberOfWrites_ == 0 )
+        {
+            return true;
+        }
+
+        numberOfWrites_ -= 1;
+
+        return false;
+    }
+
+    size_t numberOfWrites_;
+};
+
+#ifdef VTU11_ENABLE_ZLIB
+bool zlibDecompress( const Byte* source, size_t numberOfBytes, Byte* target, size_t expectedSize )
+{
+    uLongf length = expectedSize;
+
+    return uncompress( target, &length, source, numberOfBytes ) == Z_OK && length == expectedSize;
+}
+#endif
+
+} // namespace
+
+TEST_CASE( "userCompressor_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_user_test.vtu";
+
+    BasicCompressedRawBinaryAppendedWriter<CopyCompressor> writer;
+
+    writer.blockSize = 1000;
+    writer.numberOfThreads = 2;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+    CHECK( readCompressedAppendedArrays( filename, copyDecompress ) == grid.arrays( ) );
+    CHECK( vtu11testing::readFile( filename ).find( "compressor=\"vtkCopyDataCompressor\"" ) != std::string::npos );
+
+    BasicCompressedBase64Writer<CopyCompressor> base64Writer;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, base64Writer ) );
+
+    CHECK( readCompressedBase64Arrays( filename, copyDecompress ) == grid.arrays( ) );
+}
+
+#ifdef VTU11_ENABLE_ZLIB
+
+TEST_CASE( "zlibCompressData_parallel_test" )
+{
+    std::vector<double> data( 100000 );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        data[i] = static_cast<double>( ( i * 7919 ) % 1000 ) / 8.0;
+    }
+
+    std::vector<Byte> expectedArena;
+
+    auto expectedHeader = detail::zlibCompressData( data, expectedArena, 4096 );
+
+    REQUIRE( expectedHeader.size( ) == 3 + 196 );
+    REQUIRE( expectedHeader[0] == 196 );
+    REQUIRE( expectedHeader[2] == 1280 );
+    REQUIRE( std::accumulate( expectedHeader.begin( ) + 3, expectedHeader.end( ), size_t { 0 } ) == expectedArena.size( ) );
+
+    for( size_t numberOfThreads : std::vector<size_t> { 0, 1, 2, 3, 8, 500 } )
+    {
+        std::vector<Byte> arena;
+
+        auto header = detail::zlibCompressData( data, arena, 4096, numberOfThreads );
+
+        CHECK( header == expectedHeader );
+        CHECK( arena == expectedArena );
+    }
+
+    // Blocks are appended after existing content
+    std::vector<Byte> arena( 5, 7 );
+
+    CHECK( detail::zlibCompressData( data, arena, 4096, 2 ) == expectedHeader );
+
+    expectedArena.insert( expectedArena.begin( ), 5, 7 );
+
+    CHECK( arena == expectedArena );
+
+    // The arena grows with the compressed size plus one batch of 16 slots per thread, 
+    // not with the uncompressed size
+    std::vector<double> constant( 1 << 20, 1.0 );
+    std::vector<Byte> constantArena;
+
+    detail::zlibCompressData( constant, constantArena, 4096, 3 );
+
+    size_t batchSize = 3 * 16 * ZlibCompressor::compressBound( 4096 );
+
+    CHECK( constantArena.capacity( ) <= 2 * ( constantArena.size( ) + batchSize ) );
+    CHECK( constantArena.capacity( ) < constant.size( ) * sizeof( double ) / 10 );
+}
+
+TEST_CASE( "zlibCompressData_levels_test" )
+{
+    std::vector<double> data( 10000 );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        data[i] = static_cast<double>( ( i * 7919 ) % 1000 ) / 8.0;
+    }
+
+    std::vector<size_t> sizes;
+
+    for( int level = 0; level <= 9; ++level )
+    {
+        std::vector<Byte> arena;
+
+        auto header = detail::zlibCompressData( data, arena, 32768, 2, level );
+
+        REQUIRE( header.size( ) == 6 );
+
+        std::vector<double> decompressed( data.size( ) );
+        auto target = reinterpret_cast<Byte*>( decompressed.data( ) );
+
+        size_t compressedSize = 0;
+
+        for( size_t iBlock = 0; iBlock < header[0]; ++iBlock )
+        {
+            uLongf length = iBlock + 1 < header[0] ? header[1] : header[2];
+
+            REQUIRE( uncompress( target, &length, arena.data( ) + compressedSize, header[3 + iBlock] ) == Z_OK );
+
+            target += length;
+            compressedSize += header[3 + iBlock];
+        }
+
+        CHECK( compressedSize == arena.size( ) );
+        CHECK( decompressed == data );
+
+        sizes.push_back( compressedSize );
+    }
+
+    // Stored blocks are larger than the input, compressed ones must be smaller
+    CHECK( sizes[0] > data.size( ) * sizeof( double ) );
+    CHECK( sizes[1] < data.size( ) * sizeof( double ) / 2 );
+    CHECK( sizes[9] <= sizes[1] );
+
+    std::vector<Byte> arena;
+
+    CHECK_THROWS( detail::zlibCompressData( data, arena, 32768, 1, 10 ) );
+
+    // Blocks and their compressed size must fit into zlib's uInt
+    size_t maximumBlockSize = (std::numeric_limits<uInt>::max)( );
+
+    CHECK( ZlibCompressor::compressBound( 32768 ) >= 32768 );
+    CHECK_THROWS( ZlibCompressor::compressBound( maximumBlockSize ) );
+
+    if( maximumBlockSize < (std::numeric_limits<size_t>::max)( ) )
+    {
+        CHECK_THROWS( ZlibCompressor::compressBound( maximumBlockSize + 1 ) );
+    }
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_threads_test" )
+{
+    std::vector<double> points 
+    {
+        0.0, 0.0, 0.0,    0.0, 3.0, 0.0,    1.0, 2.0, 2.0, // 0, 1, 2
+        1.0, 3.0,-2.0,   -2.0, 2.0, 0.0,   -1.0, 1.0, 2.0, // 3, 4, 5
+        2.0,-2.0,-2.0,    2.0,-2.0, 2.0,   -2.0,-2.0, 2.0, // 6, 7, 8
+       -2.0,-2.0,-2.0                                      // 9
+    };
+
+    std::vector<VtkIndexType> connectivity { 5, 0, 1, 2, 2, 0, 1, 3, 3, 0, 1, 4, 4, 0, 1, 5, 8, 7, 6, 9, 0 };
+    std::vector<VtkCellType> types { 10, 10, 10, 10, 14 };
+    std::vector<VtkIndexType> offsets { 4, 8, 12, 16, 21 };
+    
+    Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+    std::vector<DataSetInfo> dataSetInfo
+    {
+        { "Flash Strength Points", DataSetType::PointData, 1 },
+        { "cell Colour", DataSetType::CellData, 1 }
+    };
+
+    std::vector<double> flashStrengthPoints { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
+    std::vector<double> cellColour { 1.0, 2.0, 3.0, 4.0, 0.0 };
+
+    std::vector<DataSetData> dataSetData { flashStrengthPoints, cellColour };
+
+    std::string filename = "testfiles/pyramids_3D/test.vtu";
+
+    REQUIRE( endianness( ) == "LittleEndian" );
+
+    CompressedRawBinaryAppendedWriter writer;
+
+    writer.numberOfThreads = 4;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, dataSetData, writer ) );
+
+    auto written = vtu11testing::readFile( filename );
+    auto expected = vtu11testing::readFile( "testfiles/pyramids_3D/raw_compressed.vtu" );
+
+    CHECK( written == expected );
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_blockSize_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_blocksize_test.vtu";
+
+    std::vector<size_t> blockSizes { 8, 1000, 1 << 20, CompressedRawBinaryAppendedWriter::AutomaticBlockSize };
+
+    for( auto blockSize : blockSizes )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+
+        writer.blockSize = blockSize;
+        writer.numberOfThreads = 3;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+    }
+}
+
+TEST_CASE( "CompressedBase64Writer_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_base64_test.vtu";
+
+    for( size_t blockSize : std::vector<size_t> { 7, 1000, 32768 } )
+    {
+        CompressedBase64Writer inlineWriter;
+        CompressedBase64AppendedWriter appendedWriter;
+
+        inlineWriter.blockSize = appendedWriter.blockSize = blockSize;
+        inlineWriter.numberOfThreads = appendedWriter.numberOfThreads = 2;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, inlineWriter ) );
+
+        CHECK( readCompressedBase64Arrays( filename, zlibDecompress ) == grid.arrays( ) );
+        
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, appendedWriter ) );
+
+        CHECK( readCompressedBase64Arrays( filename, zlibDecompress ) == grid.arrays( ) );
+    }
+
+    for( std::string mode : { "Base64InlineCompressed", "Base64AppendedCompressed" } )
+    {
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, mode ) );
+
+        auto content = vtu11testing::readFile( filename );
+
+        CHECK( readCompressedBase64Arrays( filename, zlibDecompress ) == grid.arrays( ) );
+        CHECK( content.find( "compressor=\"vtkZLibDataCompressor\"" ) != std::string::npos );
+
+        // No raw binary data in the file
+        CHECK( std::all_of( content.begin( ), content.end( ), []( char c )
+            { return std::isprint( static_cast<unsigned char>( c ) ) || c == '\n'; } ) );
+    }
+}
+
+TEST_CASE( "StreamingCompressedRawBinaryAppendedWriter_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_streaming_test.vtu";
+
+    auto appendedData = []( const std::string& content )
+    {
+        return content.substr( content.find( "<AppendedData" ) );
+    };
+
+    // Small blocks for multiple batches with one and several threads, with and without pipelining
+    std::vector<size_t> blockSizes { 100, 1000, StreamingCompressedRawBinaryAppendedWriter::AutomaticBlockSize };
+
+    for( auto blockSize : blockSizes )
+    {
+        for( size_t numberOfThreads : std::vector<size_t> { 1, 3 } )
+        {
+            for( bool pipelined : { false, true } )
+            {
+                CompressedRawBinaryAppendedWriter writer;
+                StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+                writer.blockSize = streamingWriter.blockSize = blockSize;
+                writer.numberOfThreads = streamingWriter.numberOfThreads = numberOfThreads;
+                writer.adaptiveCompression.enabled = streamingWriter.adaptiveCompression.enabled = true;
+
+                streamingWriter.pipelined = pipelined;
+
+                REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+                auto expected = vtu11testing::readFile( filename );
+
+                REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, streamingWriter ) );
+
+                CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+                CHECK( appendedData( vtu11testing::readFile( filename ) ) == appendedData( expected ) );
+
+                REQUIRE( streamingWriter.statistics.size( ) == writer.statistics.size( ) );
+
+                for( size_t i = 0; i < writer.statistics.size( ); ++i )
+                {
+                    CHECK( streamingWriter.statistics[i].compressedNumberOfBytes == writer.statistics[i].compressedNumberOfBytes );
+                    CHECK( streamingWriter.statistics[i].compressionLevel == writer.statistics[i].compressionLevel );
+                }
+            }
+        }
+    }
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, "RawBinaryStreamingCompressed" ) );
+
+    auto content = vtu11testing::readFile( filename );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+    CHECK( content.find( "offset=\"00000000000000000000\" type=\"Float64\"/>" ) != std::string::npos );
+
+    // Only empty arrays
+    std::vector<double> empty;
+    std::vector<VtkIndexType> noCells;
+    std::vector<VtkCellType> noTypes;
+
+    Vtu11UnstructuredMesh emptyMesh { empty, noCells, noCells, noTypes };
+
+    REQUIRE_NOTHROW( writeVtu( filename, emptyMesh, { }, { }, "RawBinaryStreamingCompressed" ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == std::vector<std::vector<Byte>>( 4 ) );
+
+    StreamingCompressedRawBinaryAppendedWriter pipelinedWriter;
+
+    pipelinedWriter.pipelined = true;
+
+    REQUIRE_NOTHROW( writeVtu( filename, emptyMesh, { }, { }, pipelinedWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == std::vector<std::vector<Byte>>( 4 ) );
+
+    // A stream that failed writing is not reported as non-seekable
+    NonSeekableBuffer buffer;
+    std::ostream nonSeekable( &buffer );
+    std::ostringstream failed;
+
+    failed.setstate( std::ios::badbit );
+
+    StreamingCompressedRawBinaryAppendedWriter failingWriter;
+
+    CHECK_THROWS_WITH( failingWriter.writeData( nonSeekable, grid.pointData ), Catch::Contains( "requires a seekable stream" ) );
+    CHECK_THROWS_WITH( failingWriter.writeData( failed, grid.pointData ), Catch::Contains( "Failed to write" ) );
+
+    // The offset position is recorded while writing the DataArray tag
+    std::ostringstream withoutTag;
+
+    CHECK_THROWS_WITH( failingWriter.writeData( withoutTag, grid.pointData ), Catch::Contains( "Missing offset position" ) );
+
+    // Writing fails at each write call, also while the compressing thread waits to pass on batches
+    std::vector<double> largeData( 5000 );
+
+    std::iota( largeData.begin( ), largeData.end( ), 0.5 );
+
+    for( bool pipelined : { false, true } )
+    {
+        bool writeFailed = true;
+
+        for( size_t numberOfWrites = 0; writeFailed; ++numberOfWrites )
+        {
+            StreamingCompressedRawBinaryAppendedWriter writer;
+
+            writer.blockSize = 100;
+            writer.pipelined = pipelined;
+
+            FailingBuffer failingBuffer( numberOfWrites );
+            std::ostream output( &failingBuffer );
+
+            try
+            {
+                for( size_t iDataSet = 0; iDataSet < 2; ++iDataSet )
+                {
+                    // Placeholder for the offset, as recorded when writing the DataArray tag
+                    writer.setOffsetPosition( output.tellp( ) );
+
+                    output << std::string( 100, ' ' );
+
+                    writer.writeData( output, largeData );
+                }
+
+                writer.writeAppended( output );
+
+                writeFailed = false;
+            }
+            catch( const std::runtime_error& error )
+            {
+                CHECK( std::string( error.what( ) ).find( "Failed to write" ) != std::string::npos );
+            }
+        }
+    }
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_alignment_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_aligned_test.vtu";
+
+    auto appendedData = []( const std::string& content )
+    {
+        return content.substr( content.find( '_', content.find( "<AppendedData" ) ) );
+    };
+
+    for( size_t alignment : std::vector<size_t> { 64, 4096 } )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+        StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+        writer.alignment = streamingWriter.alignment = alignment;
+        writer.blockSize = streamingWriter.blockSize = 100;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        auto expected = vtu11testing::readFile( filename );
+        auto appendedBegin = expected.find( '_', expected.find( "<AppendedData" ) ) + 1;
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+
+        // The header of each array starts at an aligned position in the file
+        for( size_t position = expected.find( "offset=\"" ); position < appendedBegin;
+                    position = expected.find( "offset=\"", position + 1 ) )
+        {
+            CHECK( ( appendedBegin + std::stoul( expected.substr( position + 8 ) ) ) % alignment == 0 );
+        }
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, streamingWriter ) );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+        CHECK( appendedData( vtu11testing::readFile( filename ) ) == appendedData( expected ) );
+    }
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_adaptive_test" )
+{
+    QuadGrid grid( 100 );
+
+    auto mesh = grid.mesh( );
+
+    // Random bytes (xorshift) are incompressible, the point data is smooth
+    std::vector<double> noise( grid.pointData.size( ) );
+
+    std::uint64_t state = 88172645463325252ull;
+
+    for( auto& value : noise )
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        std::memcpy( &value, &state, sizeof( double ) );
+    }
+
+    std::vector<DataSetInfo> dataSetInfo
+    { 
+        { "smooth", DataSetType::PointData, 1 },
+        { "noise", DataSetType::PointData, 1 }
+    };
+
+    std::string filename = "testfiles/compressed_adaptive_test.vtu";
+
+    auto expectedArrays = grid.arrays( );
+
+    expectedArrays.insert( expectedArrays.begin( ) + 1, bytes( noise ) );
+
+    CompressedRawBinaryAppendedWriter writer;
+    StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+    writer.blockSize = streamingWriter.blockSize = 4096;
+    writer.adaptiveCompression.enabled = streamingWriter.adaptiveCompression.enabled = true;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, noise }, writer ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, noise }, streamingWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+
+    for( const auto& statistics : { writer.statistics, streamingWriter.statistics } )
+    {
+        REQUIRE( statistics.size( ) == expectedArrays.size( ) );
+
+        // Smooth point data: default level
+        CHECK( statistics[0].estimatedRatio > 0.0 );
+        CHECK( statistics[0].estimatedRatio < 0.8 );
+        CHECK( statistics[0].compressionLevel == Z_DEFAULT_COMPRESSION );
+
+        // Noise: stored blocks
+        CHECK( statistics[1].estimatedRatio > 0.95 );
+        CHECK( statistics[1].compressionLevel == Z_NO_COMPRESSION );
+        CHECK( statistics[1].numberOfBytes == noise.size( ) * sizeof( double ) );
+        CHECK( statistics[1].compressedNumberOfBytes > statistics[1].numberOfBytes );
+
+        // Types array has less blocks than samples
+        CHECK( statistics.back( ).estimatedRatio < 0.0 );
+        CHECK( statistics.back( ).compressionLevel == Z_DEFAULT_COMPRESSION );
+    }
+
+    CHECK( writer.statistics[1].compressedNumberOfBytes == streamingWriter.statistics[1].compressedNumberOfBytes );
+
+    // Reduced level between the two thresholds
+    CompressedRawBinaryAppendedWriter reducingWriter;
+
+    reducingWriter.blockSize = 4096;
+    reducingWriter.adaptiveCompression.enabled = true;
+    reducingWriter.adaptiveCompression.reduceLevelRatio = 0.0;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, noise }, reducingWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    CHECK( reducingWriter.statistics[0].compressionLevel == Z_BEST_SPEED );
+    CHECK( reducingWriter.statistics[1].compressionLevel == Z_NO_COMPRESSION );
+
+    // Disabled
+    CompressedRawBinaryAppendedWriter defaultWriter;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, noise }, defaultWriter ) );
+
+    REQUIRE( defaultWriter.statistics.size( ) == expectedArrays.size( ) );
+    CHECK( defaultWriter.statistics[1].estimatedRatio < 0.0 );
+    CHECK( defaultWriter.statistics[1].compressionLevel == Z_DEFAULT_COMPRESSION );
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_dataArrayOptions_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::vector<double> cellData( grid.types.size( ), 2.0 );
+
+    DataArrayOptions stored, bestCompression;
+
+    stored.compress = false;
+    bestCompression.compressionLevel = 9;
+
+    std::vector<DataSetInfo> dataSetInfo
+    { 
+        { "stored", DataSetType::PointData, 1, stored },
+        { "best", DataSetType::CellData, 1, bestCompression }
+    };
+
+    auto expectedArrays = grid.arrays( );
+
+    expectedArrays.insert( expectedArrays.begin( ) + 1, bytes( cellData ) );
+
+    std::string filename = "testfiles/compressed_options_test.vtu";
+
+    CompressedRawBinaryAppendedWriter writer;
+    StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+    writer.compressionLevel = streamingWriter.compressionLevel = 1;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, cellData }, writer ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, cellData }, streamingWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+
+    for( const auto& statistics : { writer.statistics, streamingWriter.statistics } )
+    {
+        REQUIRE( statistics.size( ) == expectedArrays.size( ) );
+
+        CHECK( statistics[0].compressionLevel == Z_NO_COMPRESSION );
+        CHECK( statistics[1].compressionLevel == Z_BEST_COMPRESSION );
+
+        // Mesh arrays use the writer settings
+        for( size_t iArray = 2; iArray < statistics.size( ); ++iArray )
+        {
+            CHECK( statistics[iArray].compressionLevel == Z_BEST_SPEED );
+        }
+    }
+
+    // Base64 writers and writers without compression
+    CompressedBase64AppendedWriter base64Writer;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, cellData }, base64Writer ) );
+
+    CHECK( readCompressedBase64Arrays( filename, zlibDecompress ) == expectedArrays );
+    CHECK( base64Writer.statistics[0].compressionLevel == Z_NO_COMPRESSION );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData, cellData }, "RawBinary" ) );
+}
+
+TEST_CASE( "WriterSession_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_session_test.vtu";
+
+    WriterSession session;
+
+    auto write = [&]( const std::vector<double>& pointData )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+
+        writer.session = &session;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { pointData }, writer ) );
+
+        auto expectedArrays = grid.arrays( );
+
+        expectedArrays[0] = bytes( pointData );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+
+        return writer.statistics;
+    };
+
+    auto firstStep = write( grid.pointData );
+
+    REQUIRE( firstStep.size( ) == 5 );
+    CHECK( session.entries.size( ) == 4 );
+    CHECK( session.numberOfMisses == 4 );
+    CHECK( session.numberOfHits == 0 );
+
+    auto expected = vtu11testing::readFile( filename );
+
+    // Same mesh, only the point data is compressed again
+    auto secondStep = write( grid.pointData );
+
+    CHECK( session.numberOfMisses == 4 );
+    CHECK( session.numberOfHits == 4 );
+    CHECK( vtu11testing::readFile( filename ) == expected );
+
+    CHECK( !secondStep[0].cached );
+
+    for( size_t iArray = 1; iArray < secondStep.size( ); ++iArray )
+    {
+        CHECK( secondStep[iArray].cached );
+        CHECK( secondStep[iArray].compressedNumberOfBytes == firstStep[iArray].compressedNumberOfBytes );
+    }
+
+    // Changed points are detected by their hash
+    grid.points[7] += 1.0;
+
+    auto thirdStep = write( std::vector<double>( grid.pointData.size( ), 3.0 ) );
+
+    CHECK( !thirdStep[1].cached );
+    CHECK( thirdStep[2].cached );
+    CHECK( session.numberOfMisses == 5 );
+    CHECK( session.entries.size( ) == 4 );
+
+    // With a version tag, data is not hashed: the version has to change with the mesh
+    session.version = 1;
+
+    write( grid.pointData );
+    
+    CHECK( session.numberOfMisses == 9 );
+
+    grid.points[7] -= 1.0;
+    session.version = 2;
+
+    write( grid.pointData );
+    write( grid.pointData );
+
+    CHECK( session.numberOfMisses == 13 );
+    CHECK( session.numberOfHits == 11 );
+
+    // Cached arrays keep their adaptive level and are not sampled again
+    BasicWriterSession<CountingCompressor> countingSession;
+
+    auto countCompressedBlocks = [&]( )
+    {
+        BasicCompressedRawBinaryAppendedWriter<CountingCompressor> writer;
+
+        writer.session = &countingSession;
+        writer.blockSize = 16;
+        writer.adaptiveCompression.enabled = true;
+        writer.adaptiveCompression.numberOfSampleBlocks = 2;
+
+        CountingCompressor::numberOfCalls = 0;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, copyDecompress ) == grid.arrays( ) );
+
+        return CountingCompressor::numberOfCalls;
+    };
+
+    size_t numberOfPointDataBlocks = ( grid.pointData.size( ) * sizeof( double ) + 15 ) / 16;
+
+    CHECK( countCompressedBlocks( ) > numberOfPointDataBlocks + 2 );
+    CHECK( countCompressedBlocks( ) == numberOfPointDataBlocks + 2 );
+    CHECK( countingSession.numberOfHits == 4 );
+
+    // Reallocated mesh arrays and changed levels replace the entries of their arrays
+    WriterSession boundedSession;
+
+    std::vector<QuadGrid> grids( 3 );
+
+    for( size_t step = 0; step < grids.size( ); ++step )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+
+        writer.session = &boundedSession;
+        writer.compressionLevel = static_cast<int>( step % 2 ) + 1;
+
+        auto stepMesh = grids[step].mesh( );
+
+        REQUIRE_NOTHROW( writeVtu( filename, stepMesh, grid.dataSetInfo, { grids[step].pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grids[step].arrays( ) );
+        CHECK( boundedSession.entries.size( ) == 4 );
+    }
+
+    CHECK( boundedSession.numberOfMisses == 12 );
+
+    // Adding and removing fields does not move the entries of the mesh arrays
+    WriterSession fieldsSession;
+
+    std::vector<double> cellData( mesh.numberOfCells( ), 2.0 );
+
+    std::vector<DataSetInfo> twoFields
+    { 
+        { "pointData", DataSetType::PointData, 1 },
+        { "cellData", DataSetType::CellData, 1 }
+    };
+
+    auto writeFields = [&]( const std::vector<DataSetInfo>& dataSetInfo, const std::vector<DataSetData>& dataSetData )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+
+        writer.session = &fieldsSession;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, dataSetData, writer ) );
+
+        auto expectedArrays = grid.arrays( );
+
+        expectedArrays.erase( expectedArrays.begin( ) );
+
+        for( size_t iField = dataSetData.size( ); iField > 0; --iField )
+        {
+            expectedArrays.insert( expectedArrays.begin( ), bytes( dataSetData[iField - 1] ) );
+        }
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    };
+
+    writeFields( twoFields, { grid.pointData, cellData } );
+    writeFields( grid.dataSetInfo, { grid.pointData } );
+    writeFields( { }, { } );
+    writeFields( twoFields, { grid.pointData, cellData } );
+
+    CHECK( fieldsSession.numberOfMisses == 4 );
+    CHECK( fieldsSession.numberOfHits == 12 );
+    CHECK( fieldsSession.entries.size( ) == 4 );
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_timeBudget_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_time_budget_test.vtu";
+
+    size_t totalNumberOfBytes = 0;
+
+    for( const auto& array : grid.arrays( ) )
+    {
+        totalNumberOfBytes += array.size( );
+    }
+
+    auto checkLevels = [&]( const std::vector<CompressionStatistics>& statistics, int level )
+    {
+        REQUIRE( statistics.size( ) == 5 );
+
+        for( const auto& entry : statistics )
+        {
+            CHECK( entry.compressionLevel == level );
+        }
+    };
+
+    // Generous budget: the first candidate is used
+    {
+        CompressedRawBinaryAppendedWriter writer;
+
+        writer.timeBudget.seconds = 1e6;
+        writer.blockSize = 1000;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+        CHECK( writer.timeBudget.totalNumberOfBytes == totalNumberOfBytes );
+        CHECK( writer.timeBudget.selected );
+        CHECK( writer.timeBudget.level == Z_DEFAULT_COMPRESSION );
+        CHECK( writer.timeBudget.estimatedSeconds <= 1e6 );
+
+        checkLevels( writer.statistics, Z_DEFAULT_COMPRESSION );
+    }
+
+    // Impossible budget: falls back to the last candidate
+    for( bool streaming : { false, true } )
+    {
+        CompressedRawBinaryAppendedWriter writer;
+        StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+        writer.timeBudget.seconds = streamingWriter.timeBudget.seconds = 1e-12;
+        writer.blockSize = streamingWriter.blockSize = 1000;
+
+        if( streaming )
+        {
+            REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, streamingWriter ) );
+        }
+        else
+        {
+            REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+        }
+
+        const auto& timeBudget = streaming ? streamingWriter.timeBudget : writer.timeBudget;
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+        CHECK( timeBudget.level == Z_NO_COMPRESSION );
+        CHECK( timeBudget.estimatedSeconds > 1e-12 );
+
+        checkLevels( streaming ? streamingWriter.statistics : writer.statistics, Z_NO_COMPRESSION );
+    }
+
+    // Custom candidates, reset for each file
+    CompressedRawBinaryAppendedWriter writer;
+
+    writer.timeBudget.seconds = 1e-12;
+    writer.timeBudget.levels = { 9, 5 };
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+    CHECK( writer.timeBudget.level == 5 );
+
+    writer.timeBudget.seconds = 1e6;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+
+    checkLevels( writer.statistics, 9 );
+
+    // With a session, cached mesh arrays are neither counted in the estimate nor invalidated by the level
+    WriterSession session;
+
+    auto writeStep = [&]( double seconds, const std::vector<DataSetInfo>& dataSetInfo, 
+                          const std::vector<DataSetData>& dataSetData )
+    {
+        CompressedRawBinaryAppendedWriter sessionWriter;
+
+        sessionWriter.session = &session;
+        sessionWriter.timeBudget.seconds = seconds;
+        sessionWriter.blockSize = 1000;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, dataSetData, sessionWriter ) );
+
+        return sessionWriter;
+    };
+
+    auto firstStep = writeStep( 1e6, grid.dataSetInfo, { grid.pointData } );
+
+    CHECK( firstStep.timeBudget.estimatedNumberOfBytes == totalNumberOfBytes );
+    CHECK( session.numberOfMisses == 4 );
+
+    checkLevels( firstStep.statistics, Z_DEFAULT_COMPRESSION );
+
+    auto secondStep = writeStep( 1e-12, grid.dataSetInfo, { grid.pointData } );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+    CHECK( secondStep.timeBudget.estimatedNumberOfBytes == grid.pointData.size( ) * sizeof( double ) );
+    CHECK( secondStep.timeBudget.level == Z_NO_COMPRESSION );
+    CHECK( session.numberOfHits == 4 );
+
+    REQUIRE( secondStep.statistics.size( ) == 5 );
+    CHECK( secondStep.statistics[0].compressionLevel == Z_NO_COMPRESSION );
+
+    for( size_t iArray = 1; iArray < secondStep.statistics.size( ); ++iArray )
+    {
+        CHECK( secondStep.statistics[iArray].cached );
+        CHECK( secondStep.statistics[iArray].compressionLevel == Z_DEFAULT_COMPRESSION );
+    }
+
+    // Only cached arrays: nothing is compressed, so nothing is measured
+    auto thirdStep = writeStep( 1e-12, { }, { } );
+
+    CHECK( !thirdStep.timeBudget.selected );
+    CHECK( session.numberOfHits == 8 );
+    CHECK( session.numberOfMisses == 4 );
+}
+
+namespace
+{
+
+template<typename Writer>
+void checkReusedWriter( Writer writer )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_reuse_test.vtu";
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, Writer { writer } ) );
+
+    auto expected = vtu11testing::readFile( filename );
+
+    // A different file first, then the same as with a fresh writer
+    std::vector<double> otherPointData( grid.pointData.size( ), 2.0 );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { otherPointData }, writer ) );
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+    CHECK( vtu11testing::readFile( filename ) == expected );
+    CHECK( writer.statistics.size( ) == 5 );
+}
+
+} // namespace
+
+TEST_CASE( "CompressedWriters_reuse_test" )
+{
+    CompressedRawBinaryAppendedWriter writer;
+    CompressedBase64AppendedWriter base64Writer;
+    StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+    writer.alignment = streamingWriter.alignment = 16;
+    writer.blockSize = base64Writer.blockSize = streamingWriter.blockSize = 100;
+
+    checkReusedWriter( writer );
+    checkReusedWriter( base64Writer );
+    checkReusedWriter( streamingWriter );
+    checkReusedWriter( CompressedBase64Writer { } );
+}
+
+TEST_CASE( "CompressedRawBinaryAppendedWriter_narrow_test" )
+{
+    QuadGrid grid;
+
+    // Narrows the mesh arrays using the optional dataArrayOptions member of mesh generators
+    struct NarrowingMesh : Vtu11UnstructuredMesh
+    {
+        NarrowingMesh( const Vtu11UnstructuredMesh& mesh ) : Vtu11UnstructuredMesh( mesh ) { }
+
+        DataArrayOptions dataArrayOptions( )
+        {
+            DataArrayOptions options;
+
+            options.narrow = true;
+
+            return options;
+        }
+    };
+
+    NarrowingMesh mesh( grid.mesh( ) );
+
+    DataArrayOptions narrow;
+
+    narrow.narrow = true;
+
+    std::vector<DataSetInfo> dataSetInfo { { "pointData", DataSetType::PointData, 1, narrow } };
+
+    std::vector<std::vector<Byte>> expectedArrays
+    {
+        convertedBytes<float>( grid.pointData ),
+        convertedBytes<float>( grid.points ),
+        convertedBytes<std::int32_t>( grid.connectivity ),
+        convertedBytes<std::int32_t>( grid.offsets ),
+        bytes( grid.types )
+    };
+
+    std::string filename = "testfiles/compressed_narrow_test.vtu";
+
+    auto appendedData = []( const std::string& content )
+    {
+        return content.substr( content.find( "<AppendedData" ) );
+    };
+
+    // Blocks that split values, adaptive compression samples converted blocks
+    CompressedRawBinaryAppendedWriter writer;
+    StreamingCompressedRawBinaryAppendedWriter streamingWriter;
+
+    writer.blockSize = streamingWriter.blockSize = 102;
+    writer.numberOfThreads = streamingWriter.numberOfThreads = 3;
+    writer.adaptiveCompression.enabled = streamingWriter.adaptiveCompression.enabled = true;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData }, writer ) );
+
+    auto expected = vtu11testing::readFile( filename );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    CHECK( expected.find( "Name=\"pointData\" format=\"appended\" offset=\"0\" type=\"Float32\"" ) != std::string::npos );
+    CHECK( expected.find( "Name=\"connectivity\" format=\"appended\" offset=" ) != std::string::npos );
+    CHECK( expected.find( "type=\"Int64\"" ) == std::string::npos );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData }, streamingWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    CHECK( appendedData( vtu11testing::readFile( filename ) ) == appendedData( expected ) );
+
+    // Time budget measured on converted data
+    CompressedRawBinaryAppendedWriter budgetWriter;
+
+    budgetWriter.timeBudget.seconds = 1e6;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData }, budgetWriter ) );
+
+    CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    CHECK( budgetWriter.timeBudget.selected );
+
+    // Cached narrowed mesh arrays
+    WriterSession session;
+
+    for( size_t step = 0; step < 2; ++step )
+    {
+        CompressedRawBinaryAppendedWriter sessionWriter;
+
+        sessionWriter.session = &session;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData }, sessionWriter ) );
+
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == expectedArrays );
+    }
+
+    CHECK( session.numberOfHits == 4 );
+
+    CompressedBase64AppendedWriter base64Writer;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { grid.pointData }, base64Writer ) );
+
+    CHECK( readCompressedBase64Arrays( filename, zlibDecompress ) == expectedArrays );
+}
+
+TEST_CASE( "automaticBlockSize_test" )
+{
+    CHECK( detail::automaticBlockSize( 0, 1 ) == 32768 );
+    CHECK( detail::automaticBlockSize( 1000, 4 ) == 32768 );
+    CHECK( detail::automaticBlockSize( 1 << 20, 1 ) == 262144 );
+    CHECK( detail::automaticBlockSize( 1 << 20, 4 ) == 65536 );
+    CHECK( detail::automaticBlockSize( size_t { 1 } << 34, 8 ) == 1048576 );
+}
+
+#endif // VTU11_ENABLE_ZLIB
+
+#ifdef VTU11_ENABLE_LZ4
+
+TEST_CASE( "Lz4CompressedRawBinaryAppendedWriter_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_lz4_test.vtu";
+
+    auto decompress = []( const Byte* source, size_t numberOfBytes, Byte* target, size_t expectedSize )
+    {
+        return LZ4_decompress_safe( reinterpret_cast<const char*>( source ), reinterpret_cast<char*>( target ), 
+            static_cast<int>( numberOfBytes ), static_cast<int>( expectedSize ) ) == static_cast<int>( expectedSize );
+    };
+
+    for( int level : { 1, 9 } )
+    {
+        Lz4CompressedRawBinaryAppendedWriter writer;
+
+        writer.compressionLevel = level;
+        writer.blockSize = 1000;
+        writer.numberOfThreads = 2;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, decompress ) == grid.arrays( ) );
+        CHECK( vtu11testing::readFile( filename ).find( "compressor=\"vtkLZ4DataCompressor\"" ) != std::string::npos );
+    }
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, "RawBinaryLZ4Compressed" ) );
+
+    CHECK( readCompressedAppendedArrays( filename, decompress ) == grid.arrays( ) );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, "Base64InlineLZ4Compressed" ) );
+
+    CHECK( readCompressedBase64Arrays( filename, decompress ) == grid.arrays( ) );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, "Base64AppendedLZ4Compressed" ) );
+
+    CHECK( readCompressedBase64Arrays( filename, decompress ) == grid.arrays( ) );
+
+    Lz4CompressedRawBinaryAppendedWriter writer;
+
+    writer.compressionLevel = 0;
+
+    CHECK_THROWS( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+}
+
+#endif // VTU11_ENABLE_LZ4
+
+#ifdef VTU11_ENABLE_LZMA
+
+TEST_CASE( "LzmaCompressedRawBinaryAppendedWriter_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_lzma_test.vtu";
+
+    auto decompress = []( const Byte* source, size_t numberOfBytes, Byte* target, size_t expectedSize )
+    {
+        uint64_t memoryLimit = UINT64_MAX;
+        size_t inPosition = 0, outPosition = 0;
+
+        return lzma_stream_buffer_decode( &memoryLimit, 0, nullptr, source, &inPosition, 
+            numberOfBytes, target, &outPosition, expectedSize ) == LZMA_OK && outPosition == expectedSize;
+    };
+
+    for( int level : { 0, 6 } )
+    {
+        LzmaCompressedRawBinaryAppendedWriter writer;
+
+        writer.compressionLevel = level;
+        writer.blockSize = 5000;
+        writer.numberOfThreads = 2;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, decompress ) == grid.arrays( ) );
+        CHECK( vtu11testing::readFile( filename ).find( "compressor=\"vtkLZMADataCompressor\"" ) != std::string::npos );
+    }
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, "RawBinaryLZMACompressed" ) );
+
+    CHECK( readCompressedAppendedArrays( filename, decompress ) == grid.arrays( ) );
+
+    LzmaCompressedRawBinaryAppendedWriter writer;
+
+    writer.compressionLevel = 10;
+
+    CHECK_THROWS( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+}
+
+#endif // VTU11_ENABLE_LZMA
+
+#ifdef VTU11_ENABLE_LIBDEFLATE
+
+TEST_CASE( "LibdeflateCompressedRawBinaryAppendedWriter_test" )
+{
+    QuadGrid grid;
+
+    auto mesh = grid.mesh( );
+
+    std::string filename = "testfiles/compressed_libdeflate_test.vtu";
+
+    auto decompress = []( const Byte* source, size_t numberOfBytes, Byte* target, size_t expectedSize )
+    {
+        auto decompressor = libdeflate_alloc_decompressor( );
+
+        auto result = libdeflate_zlib_decompress( decompressor, source, numberOfBytes, target, expectedSize, nullptr );
+
+        libdeflate_free_decompressor( decompressor );
+
+        return result == LIBDEFLATE_SUCCESS;
+    };
+
+    for( int level : { 0, 1, 6, 12 } )
+    {
+        LibdeflateCompressedRawBinaryAppendedWriter writer;
+
+        writer.compressionLevel = level;
+        writer.blockSize = 1000;
+        writer.numberOfThreads = 2;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+
+        CHECK( readCompressedAppendedArrays( filename, decompress ) == grid.arrays( ) );
+        CHECK( vtu11testing::readFile( filename ).find( "compressor=\"vtkZLibDataCompressor\"" ) != std::string::npos );
+
+        #ifdef VTU11_ENABLE_ZLIB
+        CHECK( readCompressedAppendedArrays( filename, zlibDecompress ) == grid.arrays( ) );
+        #endif
+    }
+
+    LibdeflateCompressedBase64Writer base64Writer;
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, base64Writer ) );
+
+    CHECK( readCompressedBase64Arrays( filename, decompress ) == grid.arrays( ) );
+
+    LibdeflateCompressedRawBinaryAppendedWriter writer;
+
+    writer.compressionLevel = 13;
+
+    CHECK_THROWS( writeVtu( filename, mesh, grid.dataSetInfo, { grid.pointData }, writer ) );
+}
+
+#endif // VTU11_ENABLE_LIBDEFLATE
+
+} // namespace vtu11
@@ -71,4 +71,80 @@ TEST_CASE( "base64encode_test" )
 
 } // base64encode_test
 
+TEST_CASE( "Base64Encoder_test" )
+{
+    std::vector<Byte> bytes( 1000 );
+
+    for( size_t i = 0; i < bytes.size( ); ++i )
+    {
+        bytes[i] = static_cast<Byte>( ( i * 83 + 5 ) % 256 );
+    }
+
+    auto expected = base64Encode( bytes.begin( ), bytes.end( ) );
+
+    // Different piece sizes to have all combinations of carried over bytes
+    for( size_t pieceSize : std::vector<size_t> { 1, 2, 3, 4, 5, 7, 64, 333, 1000 } )
+    {
+        for( size_t chunkSize : std::vector<size_t> { 4, 16, 100, 64 * 1024 } )
+        {
+            std::ostringstream output;
+
+            Base64Encoder encoder( output, chunkSize );
+
+            for( size_t i = 0; i < bytes.size( ); i += pieceSize )
+            {
+                encoder.write( &bytes[i], (std::min)( pieceSize, bytes.size( ) - i ) );
+            }
+
+            encoder.finish( );
+
+            CHECK( output.str( ) == expected );
+        }
+    }
+
+    std::ostringstream output;
+
+    Base64Encoder encoder( output );
+
+    encoder.write( nullptr, 0 );
+    encoder.finish( );
+
+    CHECK( output.str( ) == "" );
+}
+
+TEST_CASE( "base64Kernels_test" )
+{
+    std::vector<Byte> bytes( 300 );
+
+    for( size_t i = 0; i < bytes.size( ); ++i )
+    {
+        bytes[i] = static_cast<Byte>( ( i * 149 + 17 ) % 256 );
+    }
+
+    for( auto isa : { detail::Base64Isa::SSSE3, detail::Base64Isa::AVX2, detail::Base64Isa::AVX512 } )
+    {
+        if( !detail::base64IsaSupported( isa ) )
+        {
+            continue;
+        }
+
+        auto kernel = detail::base64Kernel( isa );
+
+        for( size_t numberOfBytes = 0; numberOfBytes <= bytes.size( ); ++numberOfBytes )
+        {
+            std::string expected( encodedNumberOfBytes( numberOfBytes ), '\0' );
+            std::string encoded = expected;
+
+            size_t consumed = kernel( bytes.data( ), numberOfBytes, &encoded[0] );
+
+            REQUIRE( consumed % 3 == 0 );
+            REQUIRE( consumed <= numberOfBytes );
+
+            detail::base64EncodeScalar( bytes.data( ), consumed, &expected[0] );
+
+            CHECK( encoded == expected );
+        }
+    }
+}
+
 } // namespace vtu11
@@ -0,0 +1,638 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#include "vtu11/vtu11.hpp"
+#include "vtu11_testing.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace vtu11
+{
+
+TEST_CASE( "Base64BinaryAppendedWriter_test" )
+{
+    std::vector<double> data1 { 1.0, -2.5, 3.25 };
+    std::vector<VtkIndexType> data2 { 4, 8, 12, 16, 21 };
+    std::vector<VtkCellType> data3 { 10, 10, 14 };
+    std::vector<VtkCellType> data4 { 9 };
+
+    Base64BinaryAppendedWriter writer;
+    std::ostringstream output, expected;
+
+    writer.writeData( output, data1 );
+    writer.writeData( output, data2 );
+    writer.writeData( output, data3 );
+    writer.writeData( output, data4 );
+
+    writer.writeAppended( output );
+
+    // Encode each header and data set from one concatenated buffer
+    auto concatenated = [&]( const char* begin, HeaderType numberOfBytes )
+    {
+        std::vector<char> bytes( reinterpret_cast<const char*>( &numberOfBytes ), 
+                                 reinterpret_cast<const char*>( &numberOfBytes + 1 ) );
+
+        bytes.insert( bytes.end( ), begin, begin + numberOfBytes );
+
+        expected << base64Encode( bytes.begin( ), bytes.end( ) );
+    };
+
+    concatenated( reinterpret_cast<const char*>( data1.data( ) ), data1.size( ) * sizeof( double ) );
+    concatenated( reinterpret_cast<const char*>( data2.data( ) ), data2.size( ) * sizeof( VtkIndexType ) );
+    concatenated( reinterpret_cast<const char*>( data3.data( ) ), data3.size( ) * sizeof( VtkCellType ) );
+    concatenated( reinterpret_cast<const char*>( data4.data( ) ), data4.size( ) * sizeof( VtkCellType ) );
+
+    expected << "\n";
+
+    CHECK( output.str( ) == expected.str( ) );
+    CHECK( writer.offset + 1 == output.str( ).size( ) );
+}
+
+namespace
+{
+
+template<typename T>
+void checkAsciiIntegers( )
+{
+    std::vector<T> data { (std::numeric_limits<T>::min)( ), (std::numeric_limits<T>::max)( ) };
+
+    // Powers of ten, their neighbours and negations within the range
+    for( T value = 1; ; value = static_cast<T>( value * 10 ) )
+    {
+        for( T neighbour : { static_cast<T>( value - 1 ), value, static_cast<T>( value + 1 ) } )
+        {
+            data.push_back( neighbour );
+            data.push_back( static_cast<T>( -neighbour ) );
+        }
+
+        if( value > (std::numeric_limits<T>::max)( ) / 10 )
+        {
+            break;
+        }
+    }
+
+    AsciiWriter writer;
+    std::ostringstream output, expected;
+
+    writer.writeData( output, data );
+
+    for( auto value : data )
+    {
+        expected << +value << " ";
+    }
+
+    expected << "\n";
+
+    CHECK( output.str( ) == expected.str( ) );
+}
+
+} // namespace
+
+TEST_CASE( "AsciiWriter_test" )
+{
+    std::vector<double> values { 0.0, -0.0, 1.0, -2.5, 0.1, 1.0 / 3.0, 123456789.0, 1e-300, 
+        6.02214076e23, (std::numeric_limits<double>::max)( ), std::numeric_limits<double>::denorm_min( ),
+        std::numeric_limits<double>::infinity( ) };
+
+    // Enough values to write the staging buffer several times
+    for( size_t i = 1; i < 20000; ++i )
+    {
+        values.push_back( std::sin( static_cast<double>( i ) ) * std::pow( 10.0, static_cast<double>( i % 40 ) - 20.0 ) );
+    }
+
+    std::vector<VtkIndexType> indices { 4, -8, 12, 1234567890123 };
+
+    SECTION( "default format" )
+    {
+        AsciiWriter writer;
+        std::ostringstream output, expected;
+
+        writer.writeData( output, values );
+        writer.writeData( output, indices );
+
+        char buffer[64];
+
+        for( auto value : values )
+        {
+            std::snprintf( buffer, sizeof( buffer ), VTU11_ASCII_FLOATING_POINT_FORMAT, value );
+
+            expected << buffer << " ";
+        }
+
+        expected << "\n4 -8 12 1234567890123 \n";
+
+        CHECK( output.str( ) == expected.str( ) );
+    }
+
+    SECTION( "integers" )
+    {
+        checkAsciiIntegers<std::int8_t>( );
+        checkAsciiIntegers<std::uint8_t>( );
+        checkAsciiIntegers<std::int16_t>( );
+        checkAsciiIntegers<std::uint16_t>( );
+        checkAsciiIntegers<std::int32_t>( );
+        checkAsciiIntegers<std::uint32_t>( );
+        checkAsciiIntegers<std::int64_t>( );
+        checkAsciiIntegers<std::uint64_t>( );
+    }
+
+    SECTION( "parallel" )
+    {
+        // Several rounds of chunks with a partial last chunk
+        std::vector<double> manyValues( 40 * AsciiWriter::ChunkSize + 123 );
+        std::vector<VtkIndexType> manyIndices( 3 * AsciiWriter::ChunkSize + 1 );
+
+        for( size_t i = 0; i < manyValues.size( ); ++i )
+        {
+            manyValues[i] = values[i % values.size( )];
+        }
+
+        for( size_t i = 0; i < manyIndices.size( ); ++i )
+        {
+            manyIndices[i] = static_cast<VtkIndexType>( i * i ) - 1000;
+        }
+
+        for( int asciiPrecision : { DataArrayOptions::WriterAsciiPrecision, DataArrayOptions::AsciiRoundTrip } )
+        {
+            std::ostringstream expected;
+
+            DataArrayOptions options;
+
+            options.asciiPrecision = asciiPrecision;
+
+            AsciiWriter serialWriter;
+
+            serialWriter.setDataArrayOptions( options );
+            serialWriter.writeData( expected, manyValues );
+            serialWriter.writeData( expected, manyIndices );
+            serialWriter.writeData( expected, std::vector<double> { } );
+
+            for( size_t numberOfThreads : std::vector<size_t> { 0, 2, 3 } )
+            {
+                AsciiWriter writer;
+                std::ostringstream output;
+
+                writer.setDataArrayOptions( options );
+                writer.numberOfThreads = numberOfThreads;
+                writer.writeData( output, manyValues );
+                writer.writeData( output, manyIndices );
+                writer.writeData( output, std::vector<double> { } );
+
+                CHECK( output.str( ) == expected.str( ) );
+            }
+        }
+    }
+
+    SECTION( "round trip" )
+    {
+        RoundTripAsciiWriter writer;
+        std::ostringstream output;
+
+        writer.writeData( output, values );
+
+        std::istringstream input( output.str( ) );
+        std::string token;
+
+        for( auto value : values )
+        {
+            REQUIRE( input >> token );
+
+            CHECK( std::strtod( token.c_str( ), nullptr ) == value );
+            CHECK( token.size( ) <= 24 );
+        }
+
+        CHECK( !( input >> token ) );
+        CHECK( output.str( ).substr( 0, 17 ) == "0 -0 1 -2.5 0.1 0" );
+    }
+
+    SECTION( "precision" )
+    {
+        auto expected = [&]( int digits )
+        {
+            std::ostringstream stream;
+
+            char buffer[64];
+
+            for( auto value : values )
+            {
+                std::snprintf( buffer, sizeof( buffer ), "%.*g", digits, value );
+
+                stream << buffer << " ";
+            }
+
+            stream << "\n";
+
+            return stream.str( );
+        };
+
+        BasicAsciiWriter<SignificantDigits<12>> writer;
+        std::ostringstream output;
+
+        writer.writeData( output, values );
+
+        CHECK( output.str( ) == expected( 12 ) );
+
+        // Per data array at runtime, then back to the writer's policy
+        DataArrayOptions options;
+
+        for( int digits : { 1, 3, 17 } )
+        {
+            options.asciiPrecision = digits;
+
+            output.str( "" );
+            writer.setDataArrayOptions( options );
+            writer.writeData( output, values );
+
+            CHECK( output.str( ) == expected( digits ) );
+        }
+
+        output.str( "" );
+        writer.setDataArrayOptions( DataArrayOptions { } );
+        writer.writeData( output, values );
+
+        CHECK( output.str( ) == expected( 12 ) );
+
+        options.asciiPrecision = 18;
+
+        writer.setDataArrayOptions( options );
+
+        CHECK_THROWS( writer.writeData( output, values ) );
+    }
+
+    SECTION( "dataSetInfo" )
+    {
+        std::vector<double> points { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+        std::vector<VtkIndexType> connectivity { 0, 1, 2 }, offsets { 3 };
+        std::vector<VtkCellType> types { 5 };
+
+        Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+        DataArrayOptions coarse, exact;
+
+        coarse.asciiPrecision = 3;
+        exact.asciiPrecision = DataArrayOptions::AsciiRoundTrip;
+
+        std::vector<DataSetInfo> dataSetInfo
+        {
+            { "coarse", DataSetType::PointData, 1, coarse },
+            { "exact", DataSetType::PointData, 1, exact },
+            { "default", DataSetType::PointData, 1 }
+        };
+
+        std::vector<double> pi( 3, 3.141592653589793 );
+
+        std::string filename = "testfiles/ascii_precision_test.vtu";
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pi, pi, pi }, "Ascii" ) );
+
+        auto content = vtu11testing::readFile( filename );
+
+        CHECK( content.find( ">\n3.14 3.14 3.14 \n" ) != std::string::npos );
+        CHECK( content.find( ">\n3.141592653589793 3.141592653589793 3.141592653589793 \n" ) != std::string::npos );
+        CHECK( content.find( ">\n3.14159 3.14159 3.14159 \n" ) != std::string::npos );
+    }
+
+    CHECK( detail::generalFormatPrecision( "%.6g" ) == 6 );
+    CHECK( detail::generalFormatPrecision( "%.12g" ) == 12 );
+    CHECK( detail::generalFormatPrecision( "%g" ) == -1 );
+    CHECK( detail::generalFormatPrecision( "%.6e" ) == -1 );
+    CHECK( detail::generalFormatPrecision( "%.6gx" ) == -1 );
+}
+
+TEST_CASE( "RawBinaryAppendedWriter_alignment_test" )
+{
+    std::vector<double> points { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    std::vector<VtkIndexType> connectivity { 0, 1, 2 }, offsets { 3 };
+    std::vector<VtkCellType> types { 5 };
+
+    Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+    std::vector<double> pointData { 1.5, 2.5, 3.5 };
+    std::vector<DataSetInfo> dataSetInfo { { "data", DataSetType::PointData, 1 } };
+
+    std::string filename = "testfiles/aligned_appended_test.vtu";
+
+    for( size_t alignment : std::vector<size_t> { 1, 8, 64, 4096 } )
+    {
+        RawBinaryAppendedWriter writer;
+
+        writer.alignment = alignment;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData }, writer ) );
+
+        auto content = vtu11testing::readFile( filename );
+        auto appendedBegin = content.find( '_', content.find( "<AppendedData" ) ) + 1;
+
+        // The data of each array starts at an aligned position in the file
+        std::vector<std::vector<char>> arrays;
+
+        for( size_t position = content.find( "offset=\"" ); position < appendedBegin;
+                    position = content.find( "offset=\"", position + 1 ) )
+        {
+            auto dataBegin = appendedBegin + std::stoul( content.substr( position + 8 ) ) + sizeof( HeaderType );
+
+            CHECK( dataBegin % alignment == 0 );
+
+            HeaderType numberOfBytes;
+
+            std::memcpy( &numberOfBytes, content.data( ) + dataBegin - sizeof( HeaderType ), sizeof( HeaderType ) );
+
+            arrays.emplace_back( content.begin( ) + static_cast<std::ptrdiff_t>( dataBegin ), 
+                                 content.begin( ) + static_cast<std::ptrdiff_t>( dataBegin + numberOfBytes ) );
+        }
+
+        auto bytes = [ ]( const void* data, size_t numberOfBytes )
+        {
+            return std::vector<char>( static_cast<const char*>( data ), static_cast<const char*>( data ) + numberOfBytes );
+        };
+
+        std::vector<std::vector<char>> expected
+        {
+            bytes( pointData.data( ), pointData.size( ) * sizeof( double ) ),
+            bytes( points.data( ), points.size( ) * sizeof( double ) ),
+            bytes( connectivity.data( ), connectivity.size( ) * sizeof( VtkIndexType ) ),
+            bytes( offsets.data( ), offsets.size( ) * sizeof( VtkIndexType ) ),
+            bytes( types.data( ), types.size( ) * sizeof( VtkCellType ) )
+        };
+
+        CHECK( arrays == expected );
+        CHECK( ( alignment == 1 ) == ( content.find( "  _" ) == std::string::npos ) );
+    }
+}
+
+TEST_CASE( "RawBinaryAppendedWriter_threads_test" )
+{
+    std::vector<double> points { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0 };
+    std::vector<VtkIndexType> connectivity { 0, 1, 2, 1, 3, 2 }, offsets { 3, 6 };
+    std::vector<VtkCellType> types { 5, 5 };
+
+    Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+    std::vector<double> pointData { 1.5, 2.5, 3.5, 4.5 };
+    std::vector<DataSetInfo> dataSetInfo { { "data", DataSetType::PointData, 1 } };
+
+    std::string filename = "testfiles/threads_appended_test.vtu";
+
+    for( size_t alignment : std::vector<size_t> { 1, 64 } )
+    {
+        RawBinaryAppendedWriter writer;
+
+        writer.alignment = alignment;
+
+        REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData }, writer ) );
+
+        auto expected = vtu11testing::readFile( filename );
+
+        // Chunks smaller than the arrays and more threads than chunks
+        for( size_t chunkSize : std::vector<size_t> { 5, 16, 1024 } )
+        {
+            for( size_t numberOfThreads : std::vector<size_t> { 0, 3, 64 } )
+            {
+                RawBinaryAppendedWriter threadedWriter;
+
+                threadedWriter.alignment = alignment;
+                threadedWriter.chunkSize = chunkSize;
+                threadedWriter.numberOfThreads = numberOfThreads;
+
+                REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData }, threadedWriter ) );
+
+                CHECK( vtu11testing::readFile( filename ) == expected );
+            }
+        }
+    }
+}
+
+namespace
+{
+
+template<typename Writer>
+void checkReusedAppendedWriter( Writer writer )
+{
+    std::vector<double> points { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    std::vector<VtkIndexType> connectivity { 0, 1, 2 }, offsets { 3 };
+    std::vector<VtkCellType> types { 5 };
+
+    Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+    std::vector<double> pointData { 1.5, 2.5, 3.5 }, otherPointData { 2.0, 2.0, 2.0, 2.0 };
+    std::vector<DataSetInfo> dataSetInfo { { "data", DataSetType::PointData, 1 } };
+
+    std::string filename = "testfiles/appended_reuse_test.vtu";
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData }, Writer { writer } ) );
+
+    auto expected = vtu11testing::readFile( filename );
+
+    // A different file first (one more point), then the same as with a fresh writer
+    std::vector<double> otherPoints { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0 };
+
+    Vtu11UnstructuredMesh otherMesh { otherPoints, connectivity, offsets, types };
+
+    REQUIRE_NOTHROW( writeVtu( filename, otherMesh, dataSetInfo, { otherPointData }, writer ) );
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData }, writer ) );
+
+    CHECK( vtu11testing::readFile( filename ) == expected );
+    CHECK( writer.appendedData.size( ) == 5 );
+}
+
+} // namespace
+
+TEST_CASE( "AppendedWriters_reuse_test" )
+{
+    RawBinaryAppendedWriter alignedWriter, threadedWriter;
+
+    alignedWriter.alignment = threadedWriter.alignment = 16;
+    threadedWriter.numberOfThreads = 3;
+    threadedWriter.chunkSize = 8;
+
+    checkReusedAppendedWriter( RawBinaryAppendedWriter { } );
+    checkReusedAppendedWriter( alignedWriter );
+    checkReusedAppendedWriter( threadedWriter );
+    checkReusedAppendedWriter( Base64BinaryAppendedWriter { } );
+}
+
+
+namespace
+{
+
+// Narrows the mesh arrays using the optional dataArrayOptions member of mesh generators
+struct NarrowingMesh : Vtu11UnstructuredMesh
+{
+    NarrowingMesh( const Vtu11UnstructuredMesh& mesh ) : Vtu11UnstructuredMesh( mesh ) { }
+
+    DataArrayOptions dataArrayOptions( )
+    {
+        DataArrayOptions options;
+
+        options.narrow = true;
+
+        return options;
+    }
+};
+
+// Mesh with the arrays converted in advance
+struct ConvertedMesh
+{
+    std::vector<float> points_;
+    std::vector<std::int32_t> connectivity_, offsets_;
+    std::vector<VtkCellType> types_;
+
+    const std::vector<float>& points( ){ return points_; }
+    const std::vector<std::int32_t>& connectivity( ){ return connectivity_; }
+    const std::vector<std::int32_t>& offsets( ){ return offsets_; }
+    const std::vector<VtkCellType>& types( ){ return types_; }
+
+    size_t numberOfPoints( ){ return points_.size( ) / 3; }
+    size_t numberOfCells( ){ return types_.size( ); }
+};
+
+template<typename Target, typename T>
+std::vector<Target> converted( const std::vector<T>& data )
+{
+    std::vector<Target> result( data.size( ) );
+
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        result[i] = static_cast<Target>( data[i] );
+    }
+
+    return result;
+}
+
+template<typename Writer>
+void checkNarrowedMesh( Writer writer, Writer referenceWriter )
+{
+    std::vector<double> points { 0.1, 0.0, 0.0, 1.0, 1e-3, 0.0, 0.0, 1.0, 1.0 / 3.0, 1.0, 1.0, 1e30 };
+    std::vector<VtkIndexType> connectivity { 0, 1, 2, 1, 3, 2 }, offsets { 3, 6 };
+    std::vector<VtkCellType> types { 5, 5 };
+
+    NarrowingMesh mesh( Vtu11UnstructuredMesh { points, connectivity, offsets, types } );
+
+    ConvertedMesh reference { converted<float>( points ), converted<std::int32_t>( connectivity ),
+                              converted<std::int32_t>( offsets ), types };
+
+    std::string filename = "testfiles/narrow_test.vtu";
+
+    REQUIRE_NOTHROW( writeVtu( filename, reference, { }, { }, referenceWriter ) );
+
+    auto expected = vtu11testing::readFile( filename );
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, { }, { }, writer ) );
+
+    CHECK( vtu11testing::readFile( filename ) == expected );
+    CHECK( expected.find( "type=\"Float32\"" ) != std::string::npos );
+    CHECK( expected.find( "type=\"Int32\"" ) != std::string::npos );
+}
+
+} // namespace
+
+TEST_CASE( "DataSetInfo_tuple_test" )
+{
+    DataArrayOptions options;
+
+    options.compress = false;
+
+    DataSetInfo info { "pressure", DataSetType::CellData, 3, options };
+
+    static_assert( std::tuple_size<DataSetInfo>::value == 3, "DataSetInfo has three tuple elements" );
+    static_assert( std::is_same<std::tuple_element<1, DataSetInfo>::type, DataSetType>::value, "DataSetType is second" );
+
+    CHECK( std::get<0>( info ) == "pressure" );
+    CHECK( std::get<1>( info ) == DataSetType::CellData );
+    CHECK( std::get<2>( info ) == 3 );
+    CHECK( !info.options.compress );
+
+#if __cplusplus >= 201703L
+    auto [name, type, ncomponents] = info;
+
+    CHECK( name == "pressure" );
+    CHECK( type == DataSetType::CellData );
+    CHECK( ncomponents == 3 );
+#endif
+}
+
+TEST_CASE( "narrow_test" )
+{
+    checkNarrowedMesh( AsciiWriter { }, AsciiWriter { } );
+    checkNarrowedMesh( RoundTripAsciiWriter { }, RoundTripAsciiWriter { } );
+    checkNarrowedMesh( Base64BinaryWriter { }, Base64BinaryWriter { } );
+    checkNarrowedMesh( Base64BinaryAppendedWriter { }, Base64BinaryAppendedWriter { } );
+    checkNarrowedMesh( RawBinaryAppendedWriter { }, RawBinaryAppendedWriter { } );
+
+    RawBinaryAppendedWriter threadedWriter;
+
+    threadedWriter.numberOfThreads = 3;
+    threadedWriter.chunkSize = 7;
+
+    checkNarrowedMesh( threadedWriter, RawBinaryAppendedWriter { } );
+
+    // Data sets
+    std::vector<double> points { 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    std::vector<VtkIndexType> connectivity { 0, 1, 2 }, offsets { 3 };
+    std::vector<VtkCellType> types { 5 };
+
+    Vtu11UnstructuredMesh mesh { points, connectivity, offsets, types };
+
+    DataArrayOptions narrow;
+
+    narrow.narrow = true;
+
+    std::vector<DataSetInfo> dataSetInfo { { "narrowed", DataSetType::PointData, 1, narrow },
+                                           { "double", DataSetType::CellData, 1 } };
+
+    std::string filename = "testfiles/narrow_test.vtu";
+
+    std::vector<double> pointData { 0.1, -std::numeric_limits<double>::infinity( ), 3.0 };
+    std::vector<double> cellData { 0.1 };
+
+    REQUIRE_NOTHROW( writeVtu( filename, mesh, dataSetInfo, { pointData, cellData }, RoundTripAsciiWriter { } ) );
+
+    auto content = vtu11testing::readFile( filename );
+
+    CHECK( content.find( "Name=\"narrowed\" format=\"ascii\" type=\"Float32\"" ) != std::string::npos );
+    CHECK( content.find( "Name=\"double\" format=\"ascii\" type=\"Float64\"" ) != std::string::npos );
+    CHECK( content.find( "NumberOfComponents=\"3\" format=\"ascii\" type=\"Float64\"" ) != std::string::npos );
+
+    // Shortest representation that reads back as float, not as double
+    CHECK( content.find( ">\n0.1 -inf 3 \n" ) != std::string::npos );
+    CHECK( content.find( ">\n0.1 \n" ) != std::string::npos );
+
+    char buffer[64];
+
+    CHECK( std::string( buffer, RoundTripPrecision { }( buffer, 1.0f / 3.0f ) ) == "0.33333334" );
+    CHECK( std::string( buffer, RoundTripPrecision { }( buffer, 1.0 / 3.0 ) ) == "0.3333333333333333" );
+
+    // Out of range values
+    pointData[1] = 1e39;
+
+    CHECK_THROWS_WITH( writeVtu( filename, mesh, dataSetInfo, { pointData, cellData }, "RawBinary" ),
+                       Catch::Contains( "\"narrowed\" as Float32: value" ) && Catch::Contains( "at index 1" ) );
+
+    std::vector<VtkIndexType> largeConnectivity { 0, 1, VtkIndexType { 1 } << 40 };
+
+    NarrowingMesh largeMesh( Vtu11UnstructuredMesh { points, largeConnectivity, offsets, types } );
+
+    CHECK_THROWS_WITH( writeVtu( filename, largeMesh, { }, { }, "RawBinary" ),
+                       Catch::Contains( "\"connectivity\" as Int32: value 1099511627776 at index 2" ) );
+
+    // Types of parallel headers
+    REQUIRE_NOTHROW( writePVtu( "testfiles", "narrow_test", dataSetInfo, 2, narrow ) );
+
+    content = vtu11testing::readFile( "testfiles/narrow_test.pvtu" );
+
+    CHECK( content.find( "Name=\"narrowed\" type=\"Float32\"" ) != std::string::npos );
+    CHECK( content.find( "Name=\"double\" type=\"Float64\"" ) != std::string::npos );
+    CHECK( content.find( "NumberOfComponents=\"3\" type=\"Float32\"" ) != std::string::npos );
+}
+
+} // namespace vtu11
@@ -0,0 +1,994 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_COMPRESSEDWRITER_IMPL_HPP
+#define VTU11_COMPRESSEDWRITER_IMPL_HPP
+
+#include "vtu11/inc/utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace vtu11
+{
+namespace detail
+{
+
+/*! Chooses the block size as a power of two between 32 KiB and 1 MiB such that,
+ *  if possible, each thread compresses at least four blocks. Larger blocks
+ *  compress better while smaller ones balance the work between threads and
+ *  need less memory per block when reading.
+ */
+inline size_t automaticBlockSize( size_t numberOfBytes, size_t numberOfThreads )
+{
+  constexpr size_t minimumBlockSize = size_t { 1 } << 15;
+  constexpr size_t maximumBlockSize = size_t { 1 } << 20;
+
+  size_t targetBlockSize = numberOfBytes / ( 4 * resolveNumberOfThreads( numberOfThreads ) );
+  size_t blockSize = minimumBlockSize;
+
+  while( 2 * blockSize <= targetBlockSize && blockSize < maximumBlockSize )
+  {
+    blockSize *= 2;
+  }
+
+  return blockSize;
+}
+
+/*! Compresses numberOfBytes bytes of array starting at begin in independent
+ *  blocks of blockSize bytes and appends them to arena. The blocks are 
+ *  compressed in batches of a few blocks per thread directly into slots of 
+ *  the maximum compressed size at the end of arena. After each batch, the 
+ *  compressed blocks are moved together and arena is trimmed, so it grows 
+ *  with the compressed and not the uncompressed size. The blocks of each 
+ *  batch are distributed dynamically over numberOfThreads threads (0 means 
+ *  one per hardware thread), so the result does not depend on the number of
+ *  threads. Converted arrays are converted block by block. Returns the vtk 
+ *  compression header.
+ */
+template<typename Compressor>
+std::vector<HeaderType> compressBytes( const ArrayBytes& array,
+                                       size_t begin,
+                                       size_t numberOfBytes,
+                                       std::vector<Byte>& arena,
+                                       size_t blockSize,
+                                       size_t numberOfThreads,
+                                       int compressionLevel )
+{
+  VTU11_CHECK( blockSize != 0, "Compression block size must be larger than zero." );
+
+  constexpr size_t blocksPerThread = 16;
+
+  std::vector<HeaderType> header( 3, 0 );
+
+  if( numberOfBytes == 0 )
+  {
+    return header;
+  }
+
+  size_t numberOfBlocks = ( numberOfBytes - 1 ) / blockSize + 1;
+  size_t remainder = numberOfBytes - ( numberOfBlocks - 1 ) * blockSize;
+  size_t slotSize = Compressor::compressBound( blockSize );
+
+  size_t threads = (std::min)( resolveNumberOfThreads( numberOfThreads ), numberOfBlocks );
+  size_t blocksPerBatch = (std::min)( threads * blocksPerThread, numberOfBlocks );
+
+  header.resize( 3 + numberOfBlocks );
+
+  for( size_t firstBlock = 0; firstBlock < numberOfBlocks; firstBlock += blocksPerBatch )
+  {
+    size_t endBlock = (std::min)( firstBlock + blocksPerBatch, numberOfBlocks );
+    size_t batchBegin = arena.size( );
+
+    arena.resize( batchBegin + ( endBlock - firstBlock ) * slotSize );
+
+    Byte* slots = arena.data( ) + batchBegin;
+
+    std::atomic<size_t> nextBlock( firstBlock );
+
+    auto compressBlocks = [&]( )
+    {
+      Compressor compressor( compressionLevel );
+
+      std::vector<Byte> buffer( array.convert != nullptr ? blockSize : 0 );
+
+      for( size_t iBlock = nextBlock++; iBlock < endBlock; iBlock = nextBlock++ )
+      {
+        size_t numberOfBytesInBlock = iBlock + 1 < numberOfBlocks ? blockSize : remainder;
+
+        auto block = array.bytes( begin + iBlock * blockSize, numberOfBytesInBlock, buffer.data( ) );
+
+        header[3 + iBlock] = compressor.compress( block, numberOfBytesInBlock, 
+          slots + ( iBlock - firstBlock ) * slotSize, slotSize );
+      }
+    };
+
+    runInParallel( (std::min)( threads, endBlock - firstBlock ), compressBlocks );
+
+    // Move the compressed blocks together in place
+    size_t batchEnd = batchBegin;
+
+    for( size_t iBlock = firstBlock; iBlock < endBlock; ++iBlock )
+    {
+      Byte* slot = slots + ( iBlock - firstBlock ) * slotSize;
+
+      std::memmove( arena.data( ) + batchEnd, slot, static_cast<size_t>( header[3 + iBlock] ) );
+
+      batchEnd += header[3 + iBlock];
+    }
+
+    arena.resize( batchEnd );
+  }
+
+  header[0] = numberOfBlocks;
+  header[1] = blockSize;
+  header[2] = remainder;
+
+  return header;
+}
+
+//! Same as compressBytes for all bytes from begin
+template<typename Compressor>
+std::vector<HeaderType> compressBytes( const Byte* begin,
+                                       size_t numberOfBytes,
+                                       std::vector<Byte>& arena,
+                                       size_t blockSize,
+                                       size_t numberOfThreads,
+                                       int compressionLevel )
+{
+  return compressBytes<Compressor>( ArrayBytes { begin, numberOfBytes, nullptr }, 0, numberOfBytes, 
+                                    arena, blockSize, numberOfThreads, compressionLevel );
+}
+
+//! Fast non-cryptographic hash to detect changes of data
+inline std::uint64_t hashBytes( const Byte* data, size_t numberOfBytes )
+{
+  constexpr std::uint64_t multiplier = 0xff51afd7ed558ccdull;
+
+  std::uint64_t hash = 0x9e3779b97f4a7c15ull ^ numberOfBytes;
+
+  size_t numberOfWords = numberOfBytes / sizeof( std::uint64_t );
+
+  for( size_t iWord = 0; iWord < numberOfWords; ++iWord )
+  {
+    std::uint64_t word;
+
+    std::memcpy( &word, data + iWord * sizeof( std::uint64_t ), sizeof( word ) );
+
+    hash = ( hash ^ word ) * multiplier;
+    hash ^= hash >> 32;
+  }
+
+  for( size_t iByte = numberOfWords * sizeof( std::uint64_t ); iByte < numberOfBytes; ++iByte )
+  {
+    hash = ( hash ^ data[iByte] ) * multiplier;
+  }
+
+  return hash ^ ( hash >> 29 );
+}
+
+//! Same as compressBytes for the bytes of data
+template<typename Compressor, typename T>
+std::vector<HeaderType> compressData( const std::vector<T>& data,
+                                      std::vector<Byte>& arena,
+                                      size_t blockSize,
+                                      size_t numberOfThreads,
+                                      int compressionLevel )
+{
+  return compressBytes<Compressor>( reinterpret_cast<const Byte*>( data.data( ) ), data.size( ) * sizeof( T ), 
+                                    arena, blockSize, numberOfThreads, compressionLevel );
+}
+
+} // detail
+
+template<typename Compressor>
+template<typename Target, typename T>
+inline std::vector<HeaderType> CompressionSettings<Compressor>::compress( const std::vector<T>& data,
+                                                                          std::vector<Byte>& arena )
+{
+  auto array = detail::arrayBytes<Target>( data );
+  auto begin = array.data;
+  auto numberOfBytes = array.numberOfBytes;
+  auto size = resolveBlockSize( numberOfBytes );
+  auto arenaSize = arena.size( );
+
+  double estimatedRatio;
+
+  auto selectTimeBudget = [&]( size_t cachedNumberOfBytes )
+  {
+    if( timeBudget.seconds > 0.0 && !timeBudget.selected && numberOfBytes != 0 && dataArrayOptions.compress )
+    {
+      selectTimeBudgetLevel( array, size, cachedNumberOfBytes );
+    }
+  };
+
+  if( session == nullptr || !dataArrayOptions.cache )
+  {
+    selectTimeBudget( session != nullptr ? session->numberOfCachedBytes( ) : 0 );
+
+    int level = selectLevel( array, size, dataArrayOptions, estimatedRatio );
+
+    auto header = detail::compressBytes<Compressor>( array, 0, numberOfBytes, arena, size, numberOfThreads, level );
+
+    statistics.push_back( { numberOfBytes, arena.size( ) - arenaSize, estimatedRatio, level, false } );
+
+    return header;
+  }
+
+  auto version = session->version != BasicWriterSession<Compressor>::ContentHash ? 
+    session->version : detail::hashBytes( begin, data.size( ) * sizeof( T ) );
+
+  // Compared before selecting the level, which may compress sample blocks. Without the time 
+  // budget level, which depends on timing and would otherwise change from file to file.
+  auto key = std::make_tuple( begin, numberOfBytes, size, configuredLevel( dataArrayOptions, false ),
+                              adaptiveSampleBlocks( array, size, dataArrayOptions, false ) );
+
+  // Uncached arrays do not count, such that changing the fields does not move the mesh entries
+  auto& entry = session->entries[cachedArrayIndex++];
+
+  bool cached = !entry.header.empty( ) && entry.key == key && entry.version == version;
+
+  if( cached )
+  {
+    session->numberOfHits += 1;
+  }
+  else
+  {
+    // This array is compressed now, all other cached arrays are expected to hit
+    selectTimeBudget( session->numberOfCachedBytes( ) - std::get<1>( entry.key ) );
+
+    entry.key = key;
+    entry.level = selectLevel( array, size, dataArrayOptions, entry.estimatedRatio );
+    entry.compressedData.clear( );
+    entry.header = detail::compressBytes<Compressor>( array, 0, numberOfBytes, entry.compressedData, size, numberOfThreads, entry.level );
+    entry.version = version;
+
+    session->numberOfMisses += 1;
+  }
+
+  arena.insert( arena.end( ), entry.compressedData.begin( ), entry.compressedData.end( ) );
+
+  statistics.push_back( { numberOfBytes, entry.compressedData.size( ), entry.estimatedRatio, entry.level, cached } );
+
+  return entry.header;
+}
+
+template<typename Compressor>
+inline size_t BasicWriterSession<Compressor>::numberOfCachedBytes( ) const
+{
+  size_t numberOfBytes = 0;
+
+  for( const auto& entry : entries )
+  {
+    numberOfBytes += std::get<1>( entry.second.key );
+  }
+
+  return numberOfBytes;
+}
+
+template<typename Compressor>
+inline size_t CompressionSettings<Compressor>::resolveBlockSize( size_t numberOfBytes ) const
+{
+  return blockSize != AutomaticBlockSize ? blockSize : detail::automaticBlockSize( numberOfBytes, numberOfThreads );
+}
+
+template<typename Compressor>
+inline int CompressionSettings<Compressor>::configuredLevel( const DataArrayOptions& options,
+                                                             bool timeBudgetLevel ) const
+{
+  if( !options.compress )
+  {
+    return Compressor::storeLevel;
+  }
+
+  if( options.compressionLevel != DataArrayOptions::WriterCompressionLevel )
+  {
+    return options.compressionLevel;
+  }
+
+  if( timeBudgetLevel && timeBudget.seconds > 0.0 && timeBudget.selected )
+  {
+    return timeBudget.level;
+  }
+
+  return compressionLevel;
+}
+
+template<typename Compressor>
+inline size_t CompressionSettings<Compressor>::adaptiveSampleBlocks( const detail::ArrayBytes& data,
+                                                                    size_t resolvedBlockSize,
+                                                                    const DataArrayOptions& options,
+                                                                    bool timeBudgetLevel ) const
+{
+  size_t numberOfSampleBlocks = adaptiveCompression.numberOfSampleBlocks;
+  size_t numberOfFullBlocks = data.numberOfBytes / (std::max)( resolvedBlockSize, size_t { 1 } );
+
+  // Levels set by the options or the time budget are used as they are
+  bool configured = !options.compress || options.compressionLevel != DataArrayOptions::WriterCompressionLevel ||
+                    ( timeBudgetLevel && timeBudget.seconds > 0.0 && timeBudget.selected );
+
+  if( configured || !adaptiveCompression.enabled || numberOfFullBlocks < numberOfSampleBlocks )
+  {
+    return 0;
+  }
+
+  return numberOfSampleBlocks;
+}
+
+template<typename Compressor>
+inline int CompressionSettings<Compressor>::selectLevel( const detail::ArrayBytes& data,
+                                                        size_t resolvedBlockSize,
+                                                        const DataArrayOptions& options,
+                                                        double& estimatedRatio ) const
+{
+  estimatedRatio = -1.0;
+
+  size_t numberOfSampleBlocks = adaptiveSampleBlocks( data, resolvedBlockSize, options );
+
+  if( numberOfSampleBlocks == 0 )
+  {
+    return configuredLevel( options );
+  }
+
+  size_t numberOfFullBlocks = data.numberOfBytes / (std::max)( resolvedBlockSize, size_t { 1 } );
+
+  Compressor compressor( compressionLevel );
+
+  std::vector<Byte> buffer( Compressor::compressBound( resolvedBlockSize ) );
+  std::vector<Byte> converted( data.convert != nullptr ? resolvedBlockSize : 0 );
+
+  size_t compressedSize = 0;
+
+  // Evenly distributed over the data set
+  for( size_t iSample = 0; iSample < numberOfSampleBlocks; ++iSample )
+  {
+    size_t iBlock = iSample * numberOfFullBlocks / numberOfSampleBlocks;
+
+    auto block = data.bytes( iBlock * resolvedBlockSize, resolvedBlockSize, converted.data( ) );
+
+    compressedSize += compressor.compress( block, resolvedBlockSize, buffer.data( ), buffer.size( ) );
+  }
+
+  estimatedRatio = static_cast<double>( compressedSize ) / static_cast<double>( numberOfSampleBlocks * resolvedBlockSize );
+
+  if( estimatedRatio > adaptiveCompression.storeRatio )
+  {
+    return Compressor::storeLevel;
+  }
+  
+  if( estimatedRatio > adaptiveCompression.reduceLevelRatio )
+  {
+    return adaptiveCompression.reducedLevel;
+  }
+
+  return compressionLevel;
+}
+
+template<typename Compressor>
+inline void CompressionSettings<Compressor>::setDataArrayOptions( const DataArrayOptions& options )
+{
+  dataArrayOptions = options;
+}
+
+template<typename Compressor>
+inline void CompressionSettings<Compressor>::setTotalNumberOfBytes( size_t numberOfBytes )
+{
+  timeBudget.totalNumberOfBytes = numberOfBytes;
+  timeBudget.selected = false;
+
+  cachedArrayIndex = 0;
+
+  statistics.clear( );
+}
+
+template<typename Compressor>
+inline void CompressionSettings<Compressor>::selectTimeBudgetLevel( const detail::ArrayBytes& data, 
+                                                                    size_t resolvedBlockSize,
+                                                                    size_t cachedNumberOfBytes )
+{
+  size_t numberOfBytes = data.numberOfBytes;
+
+  auto levels = timeBudget.levels;
+
+  if( levels.empty( ) )
+  {
+    for( int level : { compressionLevel, Compressor::fastLevel, Compressor::storeLevel } )
+    {
+      if( std::find( levels.begin( ), levels.end( ), level ) == levels.end( ) )
+      {
+        levels.push_back( level );
+      }
+    }
+  }
+
+  size_t sampleSize = (std::min)( numberOfBytes, (std::max)( timeBudget.numberOfSampleBlocks, size_t { 1 } ) * resolvedBlockSize );
+
+  size_t remainingNumberOfBytes = timeBudget.totalNumberOfBytes > cachedNumberOfBytes ? 
+    timeBudget.totalNumberOfBytes - cachedNumberOfBytes : 0;
+
+  timeBudget.estimatedNumberOfBytes = (std::max)( remainingNumberOfBytes, numberOfBytes );
+
+  auto totalSize = static_cast<double>( timeBudget.estimatedNumberOfBytes );
+  auto numberOfThreadsUsed = static_cast<double>( detail::resolveNumberOfThreads( numberOfThreads ) );
+
+  std::vector<Byte> buffer( Compressor::compressBound( resolvedBlockSize ) );
+
+  // Converted once, such that only compression is measured
+  std::vector<Byte> converted( data.convert != nullptr ? sampleSize : 0 );
+
+  auto sample = data.bytes( 0, sampleSize, converted.data( ) );
+
+  for( int level : levels )
+  {
+    Compressor compressor( level );
+
+    size_t compressedSize = 0;
+
+    auto start = std::chrono::steady_clock::now( );
+
+    for( size_t blockBegin = 0; blockBegin < sampleSize; blockBegin += resolvedBlockSize )
+    {
+      compressedSize += compressor.compress( sample + blockBegin, (std::min)( resolvedBlockSize, 
+        sampleSize - blockBegin ), buffer.data( ), buffer.size( ) );
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now( ) - start;
+
+    // Compression scales with the number of threads, writing does not
+    double fraction = totalSize / static_cast<double>( sampleSize );
+    double ratio = static_cast<double>( compressedSize ) / static_cast<double>( sampleSize );
+
+    timeBudget.level = level;
+    timeBudget.estimatedSeconds = elapsed.count( ) * fraction / numberOfThreadsUsed + 
+                                  ratio * totalSize / timeBudget.writeBandwidth;
+
+    if( timeBudget.estimatedSeconds <= timeBudget.seconds )
+    {
+      break;
+    }
+  }
+
+  timeBudget.selected = true;
+}
+
+// ----------------------------------------------------------------
+
+template<typename Compressor>
+template<typename T>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::writeData( std::ostream& output,
+                                                                           const std::vector<T>& data )
+{
+  writeConverted<T>( output, data );
+}
+
+template<typename Compressor>
+template<typename Target, typename T>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::writeConverted( std::ostream&,
+                                                                                const std::vector<T>& data )
+{
+  size_t begin = arena.size( );
+
+  auto header = this->template compress<Target>( data, arena );
+
+  offset += sizeof( HeaderType ) * header.size( ) + arena.size( ) - begin;
+
+  spans.emplace_back( begin, arena.size( ) - begin );
+  headers.push_back( std::move( header ) );
+}
+
+template<typename Compressor>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::writeAppended( std::ostream& output )
+{
+  size_t position = 0;
+
+  for( size_t iDataSet = 0; iDataSet < spans.size( ); ++iDataSet )
+  {
+    const char* headerBegin = reinterpret_cast<const char*>( &headers[iDataSet][0] );
+    size_t numberOfHeaderBytes = headers[iDataSet].size( ) * sizeof( HeaderType );
+
+    // Same padding as in addDataAttributes
+    size_t padding = detail::alignOffset( position, 0, alignment ) - position;
+
+    detail::writeZeros( output, padding );
+
+    output.write( headerBegin, static_cast<std::streamsize>( numberOfHeaderBytes ) );
+
+    output.write( reinterpret_cast<const char*>( arena.data( ) + spans[iDataSet].first ),
+                  static_cast<std::streamsize>( spans[iDataSet].second ) );
+
+    position += padding + numberOfHeaderBytes + spans[iDataSet].second;
+  } // for iDataSet
+
+  output << "\n";
+}
+
+template<typename Compressor>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::addHeaderAttributes( StringStringMap& attributes )
+{
+  attributes["header_type"] = dataTypeString<HeaderType>( );
+  attributes["compressor"] = Compressor::name( );
+}
+
+template<typename Compressor>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::addDataAttributes( StringStringMap& attributes )
+{
+  offset = detail::alignOffset( offset, 0, alignment );
+
+  attributes["format"] = "appended";
+  attributes["offset"] = std::to_string( offset );
+}
+
+template<typename Compressor>
+inline StringStringMap BasicCompressedRawBinaryAppendedWriter<Compressor>::appendedAttributes( )
+{
+  return { { "encoding", "raw" } };
+}
+
+template<typename Compressor>
+inline void BasicCompressedRawBinaryAppendedWriter<Compressor>::setTotalNumberOfBytes( size_t numberOfBytes )
+{
+  CompressionSettings<Compressor>::setTotalNumberOfBytes( numberOfBytes );
+
+  offset = 0;
+
+  arena.clear( );
+  spans.clear( );
+  headers.clear( );
+}
+
+// ----------------------------------------------------------------
+
+namespace detail
+{
+
+//! Base64 encodes the header and the compressed blocks as two separate streams
+inline void writeCompressedBase64( std::ostream& output,
+                                   const std::vector<HeaderType>& header,
+                                   const Byte* compressedBlocks,
+                                   size_t numberOfBytes )
+{
+  Base64Encoder encoder( output );
+
+  encoder.write( header.data( ), header.size( ) * sizeof( HeaderType ) );
+  encoder.finish( );
+
+  encoder.write( compressedBlocks, numberOfBytes );
+  encoder.finish( );
+}
+
+} // namespace detail
+
+template<typename Compressor>
+template<typename T>
+inline void BasicCompressedBase64Writer<Compressor>::writeData( std::ostream& output,
+                                                                const std::vector<T>& data )
+{
+  writeConverted<T>( output, data );
+}
+
+template<typename Compressor>
+template<typename Target, typename T>
+inline void BasicCompressedBase64Writer<Compressor>::writeConverted( std::ostream& output,
+                                                                     const std::vector<T>& data )
+{
+  arena.clear( );
+
+  auto header = this->template compress<Target>( data, arena );
+
+  detail::writeCompressedBase64( output, header, arena.data( ), arena.size( ) );
+
+  output << "\n";
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64Writer<Compressor>::writeAppended( std::ostream& )
+{
+
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64Writer<Compressor>::addHeaderAttributes( StringStringMap& attributes )
+{
+  attributes["header_type"] = dataTypeString<HeaderType>( );
+  attributes["compressor"] = Compressor::name( );
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64Writer<Compressor>::addDataAttributes( StringStringMap& attributes )
+{
+  attributes["format"] = "binary";
+}
+
+template<typename Compressor>
+inline StringStringMap BasicCompressedBase64Writer<Compressor>::appendedAttributes( )
+{
+  return { };
+}
+
+// ----------------------------------------------------------------
+
+template<typename Compressor>
+template<typename T>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::writeData( std::ostream& output,
+                                                                        const std::vector<T>& data )
+{
+  writeConverted<T>( output, data );
+}
+
+template<typename Compressor>
+template<typename Target, typename T>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::writeConverted( std::ostream&,
+                                                                             const std::vector<T>& data )
+{
+  size_t begin = arena.size( );
+
+  auto header = this->template compress<Target>( data, arena );
+
+  offset += encodedNumberOfBytes( sizeof( HeaderType ) * header.size( ) );
+  offset += encodedNumberOfBytes( arena.size( ) - begin );
+
+  spans.emplace_back( begin, arena.size( ) - begin );
+  headers.push_back( std::move( header ) );
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::writeAppended( std::ostream& output )
+{
+  for( size_t iDataSet = 0; iDataSet < spans.size( ); ++iDataSet )
+  {
+    detail::writeCompressedBase64( output, headers[iDataSet], arena.data( ) + spans[iDataSet].first, spans[iDataSet].second );
+  }
+
+  output << "\n";
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::addHeaderAttributes( StringStringMap& attributes )
+{
+  attributes["header_type"] = dataTypeString<HeaderType>( );
+  attributes["compressor"] = Compressor::name( );
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::addDataAttributes( StringStringMap& attributes )
+{
+  attributes["format"] = "appended";
+  attributes["offset"] = std::to_string( offset );
+}
+
+template<typename Compressor>
+inline StringStringMap BasicCompressedBase64AppendedWriter<Compressor>::appendedAttributes( )
+{
+  return { { "encoding", "base64" } };
+}
+
+template<typename Compressor>
+inline void BasicCompressedBase64AppendedWriter<Compressor>::setTotalNumberOfBytes( size_t numberOfBytes )
+{
+  CompressionSettings<Compressor>::setTotalNumberOfBytes( numberOfBytes );
+
+  offset = 0;
+
+  arena.clear( );
+  spans.clear( );
+  headers.clear( );
+}
+
+// ----------------------------------------------------------------
+
+namespace detail
+{
+
+// Returns the stream position as offset, throws if writing failed or output is not seekable
+inline std::streamoff seekablePosition( std::ostream& output )
+{
+  // tellp also fails once failbit or badbit is set
+  VTU11_CHECK( output.good( ), "Failed to write streaming compressed data." );
+
+  std::streamoff position = output.tellp( );
+
+  VTU11_CHECK( position != std::streamoff { -1 }, "Streaming compressed output requires a seekable stream." );
+
+  return position;
+}
+
+} // namespace detail
+
+template<typename Compressor>
+template<typename T>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::writeData( std::ostream& output,
+                                                                                    const std::vector<T>& data )
+{
+  writeConverted<T>( output, data );
+}
+
+template<typename Compressor>
+template<typename Target, typename T>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::writeConverted( std::ostream& output,
+                                                                                         const std::vector<T>& data )
+{
+  detail::seekablePosition( output );
+
+  // Recorded while writing the DataArray tag, which has just been written
+  VTU11_CHECK( offsetPosition != std::streamoff { -1 }, "Missing offset position of streamed data array." );
+
+  appendedData.push_back( { detail::arrayBytes<Target>( data ), offsetPosition, this->dataArrayOptions } );
+
+  offsetPosition = -1;
+}
+
+template<typename Compressor>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::setOffsetPosition( std::streamoff position )
+{
+  offsetPosition = position;
+}
+
+template<typename Compressor>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::writeAppended( std::ostream& output )
+{
+  auto appendedBegin = detail::seekablePosition( output );
+
+  size_t numberOfBlocksPerBatch = BlocksPerThread * detail::resolveNumberOfThreads( this->numberOfThreads );
+
+  auto numberOfBlocks = [&]( const DataSet& dataSet )
+  {
+    size_t size = this->resolveBlockSize( dataSet.array.numberOfBytes );
+
+    return dataSet.array.numberOfBytes != 0 ? ( dataSet.array.numberOfBytes - 1 ) / size + 1 : 0;
+  };
+
+  auto compressBatch = [&]( const DataSet& dataSet, size_t firstBlock, Batch& batch )
+  {
+    size_t size = this->resolveBlockSize( dataSet.array.numberOfBytes );
+    size_t batchBegin = firstBlock * size;
+    size_t batchSize = (std::min)( numberOfBlocksPerBatch * size, dataSet.array.numberOfBytes - batchBegin );
+
+    batch.arena.clear( );
+    batch.header = detail::compressBytes<Compressor>( dataSet.array, batchBegin, batchSize, 
+      batch.arena, size, this->numberOfThreads, batch.level );
+  };
+
+  // Measure on the first data set before compressing concurrently
+  if( this->timeBudget.seconds > 0.0 && !this->timeBudget.selected )
+  {
+    for( const auto& dataSet : appendedData )
+    {
+      if( dataSet.array.numberOfBytes != 0 && dataSet.options.compress )
+      {
+        this->selectTimeBudgetLevel( dataSet.array, this->resolveBlockSize( dataSet.array.numberOfBytes ) );
+
+        break;
+      }
+    }
+  }
+
+  // Batch buffers are reused: the compressing thread takes them from available
+  // and passes them to the writing thread through compressed, which gives them back
+  std::vector<Batch> batches( PipelineDepth + 1 );
+
+  detail::BoundedQueue<Batch*> available( batches.size( ) ), compressed( PipelineDepth );
+
+  for( auto& batch : batches )
+  {
+    available.push( &batch );
+  }
+
+  std::exception_ptr compressionError;
+  std::thread compressionThread;
+
+  auto compressAll = [&]( )
+  {
+    try
+    {
+      for( const auto& dataSet : appendedData )
+      {
+        double estimatedRatio;
+
+        int level = this->selectLevel( dataSet.array, 
+          this->resolveBlockSize( dataSet.array.numberOfBytes ), dataSet.options, estimatedRatio );
+
+        for( size_t firstBlock = 0; firstBlock < numberOfBlocks( dataSet ); firstBlock += numberOfBlocksPerBatch )
+        {
+          Batch* batch;
+
+          if( !available.pop( batch ) )
+          {
+            return;
+          }
+
+          batch->level = level;
+          batch->estimatedRatio = estimatedRatio;
+
+          compressBatch( dataSet, firstBlock, *batch );
+
+          if( !compressed.push( batch ) )
+          {
+            return;
+          }
+        }
+      }
+    }
+    catch( ... )
+    {
+      compressionError = std::current_exception( );
+    }
+
+    compressed.close( );
+  };
+
+  bool pipeline = pipelined;
+
+  if( pipeline )
+  {
+    try
+    {
+      compressionThread = std::thread( compressAll );
+    }
+    catch( const std::system_error& )
+    {
+      pipeline = false;
+    }
+  }
+
+  // Stops the compressing thread also if writing fails, which may wait in either queue
+  struct JoinGuard
+  {
+    ~JoinGuard( )
+    {
+      available.close( );
+      compressed.close( );
+
+      if( thread.joinable( ) )
+      {
+        thread.join( );
+      }
+    }
+
+    detail::BoundedQueue<Batch*>& available;
+    detail::BoundedQueue<Batch*>& compressed;
+    std::thread& thread;
+
+  } joinGuard { available, compressed, compressionThread };
+
+  // Returns the next compressed batch in the order of writing
+  auto nextBatch = [&]( const DataSet& dataSet, size_t firstBlock ) -> Batch&
+  {
+    Batch* batch = &batches[0];
+
+    if( !pipeline )
+    {
+      if( firstBlock == 0 )
+      {
+        batch->level = this->selectLevel( dataSet.array, 
+          this->resolveBlockSize( dataSet.array.numberOfBytes ), dataSet.options, batch->estimatedRatio );
+      }
+
+      compressBatch( dataSet, firstBlock, *batch );
+    }
+    else if( !compressed.pop( batch ) )
+    {
+      compressionThread.join( );
+
+      if( compressionError )
+      {
+        std::rethrow_exception( compressionError );
+      }
+
+      VTU11_THROW( "Compression thread stopped unexpectedly." );
+    }
+
+    return *batch;
+  };
+
+  for( const auto& dataSet : appendedData )
+  {
+    auto relativePosition = static_cast<size_t>( detail::seekablePosition( output ) - appendedBegin );
+
+    detail::writeZeros( output, detail::alignOffset( relativePosition, 0, alignment ) - relativePosition );
+
+    auto headerPosition = detail::seekablePosition( output );
+
+    // Patch offset in the xml part of the file
+    std::ostringstream offset;
+
+    offset << std::setw( OffsetWidth ) << std::setfill( '0' ) << headerPosition - appendedBegin;
+
+    output.seekp( dataSet.offsetPosition );
+    output.write( offset.str( ).data( ), static_cast<std::streamsize>( OffsetWidth ) );
+    output.seekp( headerPosition );
+
+    // Write header with placeholders for the compressed block sizes
+    size_t size = this->resolveBlockSize( dataSet.array.numberOfBytes );
+    size_t numberOfDataSetBlocks = numberOfBlocks( dataSet );
+    size_t compressedSize = 0;
+
+    HeaderType header[3] = { numberOfDataSetBlocks, numberOfDataSetBlocks != 0 ? size : 0, 
+                             numberOfDataSetBlocks != 0 ? dataSet.array.numberOfBytes - ( numberOfDataSetBlocks - 1 ) * size : 0 };
+
+    output.write( reinterpret_cast<const char*>( header ), static_cast<std::streamsize>( sizeof( header ) ) );
+
+    detail::writeZeros( output, numberOfDataSetBlocks * sizeof( HeaderType ) );
+
+    // Overwritten by the batches, data sets without blocks are not sampled
+    double estimatedRatio = -1.0;
+
+    int level = this->configuredLevel( dataSet.options );
+
+    // Write batches of compressed blocks, then patch their sizes in the header
+    for( size_t firstBlock = 0; firstBlock < numberOfDataSetBlocks; firstBlock += numberOfBlocksPerBatch )
+    {
+      auto& batch = nextBatch( dataSet, firstBlock );
+
+      output.write( reinterpret_cast<const char*>( batch.arena.data( ) ), 
+                    static_cast<std::streamsize>( batch.arena.size( ) ) );
+
+      compressedSize += batch.arena.size( );
+      level = batch.level;
+      estimatedRatio = batch.estimatedRatio;
+
+      auto batchEnd = detail::seekablePosition( output );
+      auto sizesPosition = headerPosition + static_cast<std::streamoff>( ( 3 + firstBlock ) * sizeof( HeaderType ) );
+
+      output.seekp( sizesPosition );
+      output.write( reinterpret_cast<const char*>( &batch.header[3] ), 
+                    static_cast<std::streamsize>( batch.header[0] * sizeof( HeaderType ) ) );
+      output.seekp( batchEnd );
+
+      if( pipeline )
+      {
+        available.push( &batch );
+      }
+    } // for firstBlock
+
+    this->statistics.push_back( { dataSet.array.numberOfBytes, compressedSize, estimatedRatio, level, false } );
+  } // for dataSet
+
+  output << "\n";
+
+  VTU11_CHECK( output.good( ), "Failed to write streaming compressed data." );
+}
+
+template<typename Compressor>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::addHeaderAttributes( StringStringMap& attributes )
+{
+  attributes["header_type"] = dataTypeString<HeaderType>( );
+  attributes["compressor"] = Compressor::name( );
+}
+
+template<typename Compressor>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::addDataAttributes( StringStringMap& attributes )
+{
+  attributes["format"] = "appended";
+  attributes["offset"] = std::string( OffsetWidth, '0' );
+}
+
+template<typename Compressor>
+inline StringStringMap BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::appendedAttributes( )
+{
+  return { { "encoding", "raw" } };
+}
+
+template<typename Compressor>
+inline void BasicStreamingCompressedRawBinaryAppendedWriter<Compressor>::setTotalNumberOfBytes( size_t numberOfBytes )
+{
+  CompressionSettings<Compressor>::setTotalNumberOfBytes( numberOfBytes );
+
+  appendedData.clear( );
+
+  offsetPosition = -1;
+}
+
+} // namespace vtu11
+
+#endif // VTU11_COMPRESSEDWRITER_IMPL_HPP
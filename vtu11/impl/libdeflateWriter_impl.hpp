@@ -0,0 +1,50 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LIBDEFLATEWRITER_IMPL_HPP
+#define VTU11_LIBDEFLATEWRITER_IMPL_HPP
+
+#ifdef VTU11_ENABLE_LIBDEFLATE
+
+#include "vtu11/inc/utilities.hpp"
+
+namespace vtu11
+{
+
+inline LibdeflateCompressor::LibdeflateCompressor( int compressionLevel ) :
+  compressor( libdeflate_alloc_compressor( compressionLevel ) )
+{
+  VTU11_CHECK( compressor != nullptr, "Error initializing libdeflate compression with level " +
+               std::to_string( compressionLevel ) + " (must be between 0 and 12)." );
+}
+
+inline LibdeflateCompressor::~LibdeflateCompressor( )
+{
+  libdeflate_free_compressor( compressor );
+}
+
+inline size_t LibdeflateCompressor::compressBound( size_t numberOfBytes )
+{
+  // Without compressor the bound is valid for all compression levels
+  return libdeflate_zlib_compress_bound( nullptr, numberOfBytes );
+}
+
+inline size_t LibdeflateCompressor::compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity )
+{
+  size_t compressedSize = libdeflate_zlib_compress( compressor, source, numberOfBytes, target, capacity );
+
+  VTU11_CHECK( compressedSize != 0, "Error in libdeflate compression." );
+
+  return compressedSize;
+}
+
+} // namespace vtu11
+
+#endif // VTU11_ENABLE_LIBDEFLATE
+#endif // VTU11_LIBDEFLATEWRITER_IMPL_HPP
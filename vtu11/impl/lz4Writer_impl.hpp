@@ -0,0 +1,48 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LZ4WRITER_IMPL_HPP
+#define VTU11_LZ4WRITER_IMPL_HPP
+
+#ifdef VTU11_ENABLE_LZ4
+
+#include "vtu11/inc/utilities.hpp"
+
+namespace vtu11
+{
+
+inline Lz4Compressor::Lz4Compressor( int compressionLevel ) :
+  acceleration( 10 - compressionLevel ), state( static_cast<size_t>( LZ4_sizeofState( ) ) )
+{
+  VTU11_CHECK( compressionLevel >= 1 && compressionLevel <= 9, "Invalid LZ4 compression level " +
+               std::to_string( compressionLevel ) + " (must be between 1 and 9)." );
+}
+
+inline size_t Lz4Compressor::compressBound( size_t numberOfBytes )
+{
+  VTU11_CHECK( numberOfBytes <= LZ4_MAX_INPUT_SIZE, "Size too large for LZ4 compression." );
+
+  return static_cast<size_t>( LZ4_compressBound( static_cast<int>( numberOfBytes ) ) );
+}
+
+inline size_t Lz4Compressor::compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity )
+{
+  int compressedLength = LZ4_compress_fast_extState( state.data( ), 
+    reinterpret_cast<const char*>( source ), reinterpret_cast<char*>( target ),
+    static_cast<int>( numberOfBytes ), static_cast<int>( capacity ), acceleration );
+
+  VTU11_CHECK( compressedLength > 0, "Error in LZ4 compression." );
+
+  return static_cast<size_t>( compressedLength );
+}
+
+} // namespace vtu11
+
+#endif // VTU11_ENABLE_LZ4
+#endif // VTU11_LZ4WRITER_IMPL_HPP
@@ -0,0 +1,67 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LZMAWRITER_IMPL_HPP
+#define VTU11_LZMAWRITER_IMPL_HPP
+
+#ifdef VTU11_ENABLE_LZMA
+
+#include "vtu11/inc/utilities.hpp"
+
+namespace vtu11
+{
+
+inline LzmaCompressor::LzmaCompressor( int compressionLevel ) :
+  preset( static_cast<std::uint32_t>( compressionLevel ) ), stream( )
+{
+  VTU11_CHECK( compressionLevel >= 0 && compressionLevel <= 9, "Invalid LZMA compression level " +
+               std::to_string( compressionLevel ) + " (must be between 0 and 9)." );
+}
+
+inline LzmaCompressor::~LzmaCompressor( )
+{
+  lzma_end( &stream );
+}
+
+inline size_t LzmaCompressor::compressBound( size_t numberOfBytes )
+{
+  size_t bound = lzma_stream_buffer_bound( numberOfBytes );
+
+  VTU11_CHECK( bound != 0, "Size too large for LZMA compression." );
+
+  return bound;
+}
+
+inline size_t LzmaCompressor::compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity )
+{
+  // Initializing the same encoder again on this stream reuses its memory
+  lzma_ret errorCode = lzma_easy_encoder( &stream, preset, LZMA_CHECK_CRC64 );
+
+  stream.next_in = source;
+  stream.avail_in = numberOfBytes;
+  stream.next_out = target;
+  stream.avail_out = capacity;
+
+  if( errorCode == LZMA_OK )
+  {
+    errorCode = lzma_code( &stream, LZMA_FINISH );
+  }
+
+  if( errorCode != LZMA_STREAM_END )
+  {
+    throw std::runtime_error( "Error in LZMA compression (code " + std::to_string( static_cast<int>( errorCode ) ) + ")." );
+  }
+
+  return capacity - stream.avail_out;
+}
+
+} // namespace vtu11
+
+#endif // VTU11_ENABLE_LZMA
+#endif // VTU11_LZMAWRITER_IMPL_HPP
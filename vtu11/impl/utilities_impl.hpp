@@ -10,23 +10,39 @@
 #ifndef VTU11_UTILITIES_IMPL_HPP
 #define VTU11_UTILITIES_IMPL_HPP
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <exception>
+#include <ostream>
+#include <system_error>
+#include <thread>
 
 namespace vtu11
 {
 namespace detail
 {
 
+// Optionally stores the stream position of the value of attribute valueName in valuePosition
 inline void writeTag( std::ostream& output,
                       const std::string& name,
                       const StringStringMap& attributes,
-                      const std::string& tagEnd )
+                      const std::string& tagEnd,
+                      const std::string& valueName = "",
+                      std::streamoff* valuePosition = nullptr )
 {
     output << "<" << name;
 
     for( const auto& attribute : attributes )
     {
-        output << " " << attribute.first << "=\"" << attribute.second << "\"";
+        output << " " << attribute.first << "=\"";
+
+        if( valuePosition != nullptr && attribute.first == valueName )
+        {
+            *valuePosition = output.tellp( );
+        }
+
+        output << attribute.second << "\"";
     }
 
     output << tagEnd << "\n";
@@ -70,72 +86,592 @@ inline std::string endianness( )
 
 constexpr char base64Map[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-template<typename Iterator>
-inline std::string base64Encode( Iterator begin, Iterator end )
+namespace detail
 {
-    constexpr size_t size = sizeof( decltype( *begin ) );
 
-    size_t length = static_cast<size_t>( std::distance( begin, end ) );
-    size_t rawBytes = length * size;
-    size_t encodedBytes = ( rawBytes / 3 + 1 ) * 4;
+inline size_t base64EncodeScalar( const Byte* source, size_t numberOfBytes, char* target )
+{
+    size_t numberOfTriplets = numberOfBytes / 3;
+
+    for( size_t i = 0; i < numberOfTriplets; ++i )
+    {
+        auto bits = static_cast<std::uint32_t>( source[0] ) << 16 |
+                    static_cast<std::uint32_t>( source[1] ) << 8  |
+                    static_cast<std::uint32_t>( source[2] );
+
+        target[0] = base64Map[( bits >> 18 ) & 0x3f];
+        target[1] = base64Map[( bits >> 12 ) & 0x3f];
+        target[2] = base64Map[( bits >>  6 ) & 0x3f];
+        target[3] = base64Map[bits & 0x3f];
+
+        source += 3;
+        target += 4;
+    }
+
+    return 3 * numberOfTriplets;
+}
+
+} // namespace detail
+} // namespace vtu11
+
+#if !defined( VTU11_DISABLE_SIMD ) && ( defined( __GNUC__ ) || defined( __clang__ ) ) && \
+    ( defined( __x86_64__ ) || defined( __i386__ ) )
+
+#define VTU11_ENABLE_SIMD_BASE64
+#define VTU11_TARGET( isa ) __attribute__(( target( isa ) ))
+
+#include <immintrin.h>
 
-    std::string result;
+namespace vtu11
+{
+namespace detail
+{
 
-    result.reserve( encodedBytes );
+/* 
+ * Vectorized versions following W. Mula and D. Lemire, "Faster Base64 Encoding
+ * and Decoding Using AVX2 Instructions", ACM Transactions on the Web, 2018.
+ * Each kernel reads a few bytes more than it consumes, so they stop early and
+ * leave the remaining triplets to the scalar version.
+ */
+
+// Reorders each triplet (b0, b1, b2) into the 32-bit lane [b1, b0, b2, b1]
+VTU11_TARGET( "ssse3" ) inline
+__m128i base64Split128( __m128i bytes )
+{
+    bytes = _mm_shuffle_epi8( bytes, _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 ) );
+
+    // Move the four 6-bit indices of each lane into separate bytes
+    __m128i indices0 = _mm_mulhi_epu16( _mm_and_si128( bytes, _mm_set1_epi32( 0x0fc0fc00 ) ), 
+                                        _mm_set1_epi32( 0x04000040 ) );
+
+    __m128i indices1 = _mm_mullo_epi16( _mm_and_si128( bytes, _mm_set1_epi32( 0x003f03f0 ) ),
+                                        _mm_set1_epi32( 0x01000010 ) );
+
+    return _mm_or_si128( indices0, indices1 );
+}
+
+// Maps indices 0-63 to characters by adding an offset depending on the index range
+VTU11_TARGET( "ssse3" ) inline
+__m128i base64Lookup128( __m128i indices )
+{
+    __m128i offsetLookup = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, 
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, 
+                                          '/' - 63, 'A', 0, 0 );
 
-    auto it = begin;
-    size_t byteIndex = 0;
+    __m128i range = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) );
+    __m128i isUpperCase = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices );
 
-    auto next = [&]( )
+    range = _mm_or_si128( range, _mm_and_si128( isUpperCase, _mm_set1_epi8( 13 ) ) );
+
+    return _mm_add_epi8( indices, _mm_shuffle_epi8( offsetLookup, range ) );
+}
+
+VTU11_TARGET( "ssse3" ) inline
+size_t base64EncodeSSSE3( const Byte* source, size_t numberOfBytes, char* target )
+{
+    size_t consumed = 0;
+
+    // Reads 16 bytes and consumes 12
+    for( ; consumed + 16 <= numberOfBytes; consumed += 12 )
     {
-        char byte = *( reinterpret_cast<const char*>( &( *it ) ) + byteIndex++ );
+        __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + consumed ) );
 
-        if( byteIndex == size )
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( target ), base64Lookup128( base64Split128( bytes ) ) );
+
+        target += 16;
+    }
+
+    return consumed;
+}
+
+VTU11_TARGET( "avx2" ) inline
+__m256i base64Split256( __m256i bytes )
+{
+    bytes = _mm256_shuffle_epi8( bytes, _mm256_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                          1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 ) );
+
+    __m256i indices0 = _mm256_mulhi_epu16( _mm256_and_si256( bytes, _mm256_set1_epi32( 0x0fc0fc00 ) ), 
+                                           _mm256_set1_epi32( 0x04000040 ) );
+
+    __m256i indices1 = _mm256_mullo_epi16( _mm256_and_si256( bytes, _mm256_set1_epi32( 0x003f03f0 ) ),
+                                           _mm256_set1_epi32( 0x01000010 ) );
+
+    return _mm256_or_si256( indices0, indices1 );
+}
+
+VTU11_TARGET( "avx2" ) inline
+__m256i base64Lookup256( __m256i indices )
+{
+    __m256i offsetLookup = _mm256_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, 
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, 
+                                             '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, 
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, 
+                                             '/' - 63, 'A', 0, 0 );
+
+    __m256i range = _mm256_subs_epu8( indices, _mm256_set1_epi8( 51 ) );
+    __m256i isUpperCase = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), indices );
+
+    range = _mm256_or_si256( range, _mm256_and_si256( isUpperCase, _mm256_set1_epi8( 13 ) ) );
+
+    return _mm256_add_epi8( indices, _mm256_shuffle_epi8( offsetLookup, range ) );
+}
+
+VTU11_TARGET( "avx2" ) inline
+size_t base64EncodeAVX2( const Byte* source, size_t numberOfBytes, char* target )
+{
+    size_t consumed = 0;
+
+    // Reads 28 bytes and consumes 24, one triplet group of 12 bytes per 128-bit lane
+    for( ; consumed + 28 <= numberOfBytes; consumed += 24 )
+    {
+        __m128i lower = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + consumed ) );
+        __m128i upper = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + consumed + 12 ) );
+
+        __m256i bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( lower ), upper, 1 );
+
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( target ), base64Lookup256( base64Split256( bytes ) ) );
+
+        target += 32;
+    }
+
+    return consumed;
+}
+
+VTU11_TARGET( "avx512f,avx512bw,avx512vbmi" ) inline
+size_t base64EncodeAVX512( const Byte* source, size_t numberOfBytes, char* target )
+{
+    // Same byte order per 32-bit lane as in base64Split128, but across the whole register
+    __m512i split = _mm512_setr_epi32( 0x01020001, 0x04050304, 0x07080607, 0x0a0b090a, 
+                                       0x0d0e0c0d, 0x10110f10, 0x13141213, 0x16171516, 
+                                       0x191a1819, 0x1c1d1b1c, 0x1f201e1f, 0x22232122,
+                                       0x25262425, 0x28292728, 0x2b2c2a2b, 0x2e2f2d2e );
+
+    // Bit offsets of the four indices within each 32-bit lane
+    __m512i shifts = _mm512_set1_epi64( 0x3036242a1016040a );
+    __m512i lookup = _mm512_loadu_si512( base64Map );
+
+    const __mmask64 allLanes = ~__mmask64 { 0 };
+
+    size_t consumed = 0;
+
+    // Reads 64 bytes and consumes 48
+    for( ; consumed + 64 <= numberOfBytes; consumed += 48 )
+    {
+        __m512i bytes = _mm512_loadu_si512( source + consumed );
+
+        // Merge-masked variants with all lanes selected, since the unmasked ones trigger
+        // false maybe-uninitialized warnings with some gcc versions
+        bytes = _mm512_mask_permutexvar_epi8( bytes, allLanes, split, bytes );
+        bytes = _mm512_mask_multishift_epi64_epi8( bytes, allLanes, shifts, bytes );
+
+        _mm512_storeu_si512( target, _mm512_mask_permutexvar_epi8( bytes, allLanes, bytes, lookup ) );
+
+        target += 64;
+    }
+
+    return consumed;
+}
+
+} // namespace detail
+} // namespace vtu11
+
+#undef VTU11_TARGET
+
+#endif
+
+namespace vtu11
+{
+namespace detail
+{
+
+inline bool base64IsaSupported( Base64Isa isa )
+{
+    switch( isa )
+    {
+        case Base64Isa::Scalar: return true;
+
+    #ifdef VTU11_ENABLE_SIMD_BASE64
+        case Base64Isa::SSSE3:  return __builtin_cpu_supports( "ssse3" );
+        case Base64Isa::AVX2:   return __builtin_cpu_supports( "avx2" );
+        case Base64Isa::AVX512: return __builtin_cpu_supports( "avx512bw" ) && 
+                                       __builtin_cpu_supports( "avx512vbmi" );
+    #else
+        case Base64Isa::SSSE3:
+        case Base64Isa::AVX2:
+        case Base64Isa::AVX512: return false;
+    #endif
+    }
+
+    return false;
+}
+
+inline Base64Isa base64BestIsa( )
+{
+    for( auto isa : { Base64Isa::AVX512, Base64Isa::AVX2, Base64Isa::SSSE3 } )
+    {
+        if( base64IsaSupported( isa ) )
         {
-            it++;
-            byteIndex = 0;
+            return isa;
         }
+    }
 
-        return byte;
-    };
+    return Base64Isa::Scalar;
+}
 
-    auto encodeTriplet = [&]( std::array<char, 3> bytes, size_t padding )
+inline Base64Kernel base64Kernel( Base64Isa isa )
+{
+    VTU11_CHECK( base64IsaSupported( isa ), "Base64 instruction set not supported." );
+
+    switch( isa )
     {
-        char tmp[5] = { base64Map[(   bytes[0] & 0xfc ) >> 2],
-                        base64Map[( ( bytes[0] & 0x03 ) << 4 ) + ( ( bytes[1] & 0xf0 ) >> 4 )],
-                        base64Map[( ( bytes[1] & 0x0f ) << 2 ) + ( ( bytes[2] & 0xc0 ) >> 6 )],
-                        base64Map[bytes[2] & 0x3f],
-                        '\0' };
+    #ifdef VTU11_ENABLE_SIMD_BASE64
+        case Base64Isa::SSSE3:  return &base64EncodeSSSE3;
+        case Base64Isa::AVX2:   return &base64EncodeAVX2;
+        case Base64Isa::AVX512: return &base64EncodeAVX512;
+    #else
+        case Base64Isa::SSSE3:
+        case Base64Isa::AVX2:
+        case Base64Isa::AVX512:
+    #endif
+        case Base64Isa::Scalar: return &base64EncodeScalar;
+    }
+
+    return &base64EncodeScalar;
+}
 
-        std::fill( tmp + 4 - padding, tmp + 4, '=' );
+inline size_t base64EncodeTriplets( const Byte* source, size_t numberOfBytes, char* target )
+{
+    // Selected once on first use (thread-safe initialization of static locals)
+    static const Base64Kernel kernel = base64Kernel( base64BestIsa( ) );
+
+    size_t consumed = kernel( source, numberOfBytes, target );
+
+    return consumed + base64EncodeScalar( source + consumed, numberOfBytes - consumed, 
+                                          target + encodedNumberOfBytes( consumed ) );
+}
 
-        result += tmp;
+inline void base64EncodeBytes( const Byte* source, size_t numberOfBytes, char* target )
+{
+    size_t consumed = base64EncodeTriplets( source, numberOfBytes, target );
+    size_t remainder = numberOfBytes - consumed;
+
+    if( remainder != 0 )
+    {
+        Byte bytes[3] = { source[consumed], remainder == 2 ? source[consumed + 1] : Byte { 0 }, 0 };
+
+        char* tail = target + encodedNumberOfBytes( consumed );
+
+        base64EncodeScalar( bytes, 3, tail );
+
+        std::fill( tail + remainder + 1, tail + 4, '=' );
+    }
+}
+
+inline size_t resolveNumberOfThreads( size_t numberOfThreads )
+{
+    if( numberOfThreads == 0 )
+    {
+        numberOfThreads = std::thread::hardware_concurrency( );
+    }
+
+    return (std::max)( numberOfThreads, size_t { 1 } );
+}
+
+template<typename Function>
+inline void runInParallel( size_t numberOfThreads, Function&& function )
+{
+    numberOfThreads = resolveNumberOfThreads( numberOfThreads );
+
+    std::vector<std::exception_ptr> errors( numberOfThreads );
+    std::vector<std::thread> threads;
+
+    auto run = [&]( size_t iThread )
+    {
+        try
+        {
+            function( );
+        }
+        catch( ... )
+        {
+            errors[iThread] = std::current_exception( );
+        }
     };
 
-    // in steps of 3
-    for( size_t i = 0; i < rawBytes / 3; ++i )
+    try
+    {
+        for( size_t iThread = 1; iThread < numberOfThreads; ++iThread )
+        {
+            threads.emplace_back( run, iThread );
+        }
+    }
+    catch( const std::system_error& )
+    {
+        // Continue with the threads created so far
+    }
+
+    run( 0 );
+
+    for( auto& thread : threads )
+    {
+        thread.join( );
+    }
+
+    for( const auto& error : errors )
+    {
+        if( error )
+        {
+            std::rethrow_exception( error );
+        }
+    }
+}
+
+inline void writeZeros( std::ostream& output, size_t numberOfBytes )
+{
+    const char zeros[4096] = { };
+
+    while( numberOfBytes != 0 )
     {
-        encodeTriplet( { next( ), next( ), next( ) }, 0 );
+        auto chunkSize = (std::min)( numberOfBytes, sizeof( zeros ) );
+
+        output.write( zeros, static_cast<std::streamsize>( chunkSize ) );
+
+        numberOfBytes -= chunkSize;
     }
+}
 
-    // cleanup
-    if( it != end )
+inline size_t alignOffset( size_t offset, size_t headerSize, size_t alignment )
+{
+    if( alignment <= 1 )
     {
-        std::array<char, 3> bytes { '\0', '\0', '\0' };
+        return offset;
+    }
+
+    size_t remainder = ( offset + headerSize ) % alignment;
 
-        size_t remainder = static_cast<size_t>( std::distance( it, end ) ) * size - static_cast<size_t>( byteIndex );
+    return remainder != 0 ? offset + alignment - remainder : offset;
+}
 
-        for( size_t i = 0; i < remainder; ++i )
+template<typename Target, typename T>
+inline void convertBytes( const Byte* data, size_t firstByte, size_t numberOfBytes, Byte* target )
+{
+    constexpr size_t bufferSize = 1024;
+
+    auto values = reinterpret_cast<const T*>( data );
+
+    Target buffer[bufferSize];
+
+    // Convert the values overlapping the requested bytes, then copy only these bytes
+    for( size_t byte = firstByte, end = firstByte + numberOfBytes; byte < end; )
+    {
+        size_t firstValue = byte / sizeof( Target );
+        size_t numberOfValues = (std::min)( ( end - firstValue * sizeof( Target ) + sizeof( Target ) - 1 ) / sizeof( Target ), bufferSize );
+
+        for( size_t iValue = 0; iValue < numberOfValues; ++iValue )
         {
-            bytes[i] = next( );
+            buffer[iValue] = static_cast<Target>( values[firstValue + iValue] );
         }
 
-        encodeTriplet( bytes, 3 - remainder );
+        size_t begin = byte - firstValue * sizeof( Target );
+        size_t size = (std::min)( numberOfValues * sizeof( Target ) - begin, end - byte );
+
+        std::memcpy( target, reinterpret_cast<const Byte*>( buffer ) + begin, size );
+
+        target += size;
+        byte += size;
+    }
+}
+
+inline const Byte* ArrayBytes::bytes( size_t begin, size_t size, Byte* buffer ) const
+{
+    if( convert == nullptr )
+    {
+        return data + begin;
+    }
+
+    convert( data, begin, size, buffer );
+
+    return buffer;
+}
+
+template<typename Target, typename T>
+inline ArrayBytes arrayBytes( const std::vector<T>& data )
+{
+    ConvertFunction convert = std::is_same<Target, T>::value ? nullptr : &convertBytes<Target, T>;
+
+    return { reinterpret_cast<const Byte*>( data.data( ) ), data.size( ) * sizeof( Target ), convert };
+}
+
+template<typename Function>
+inline void forEachChunk( const ArrayBytes& array, Function&& function )
+{
+    if( array.convert == nullptr )
+    {
+        function( array.data, array.numberOfBytes );
+
+        return;
+    }
+
+    std::vector<Byte> buffer( (std::min)( array.numberOfBytes, size_t { 64 * 1024 } ) );
+
+    for( size_t begin = 0; begin < array.numberOfBytes; begin += buffer.size( ) )
+    {
+        size_t size = (std::min)( buffer.size( ), array.numberOfBytes - begin );
+
+        function( array.bytes( begin, size, buffer.data( ) ), size );
+    }
+}
+
+template<typename T>
+inline BoundedQueue<T>::BoundedQueue( size_t capacity ) :
+    capacity_( (std::max)( capacity, size_t { 1 } ) ), closed_( false )
+{ }
+
+template<typename T>
+inline bool BoundedQueue<T>::push( T value )
+{
+    std::unique_lock<std::mutex> lock( mutex_ );
+
+    notFull_.wait( lock, [this]( ){ return closed_ || values_.size( ) < capacity_; } );
+
+    if( closed_ )
+    {
+        return false;
+    }
+
+    values_.push_back( std::move( value ) );
+    notEmpty_.notify_one( );
+
+    return true;
+}
+
+template<typename T>
+inline bool BoundedQueue<T>::pop( T& value )
+{
+    std::unique_lock<std::mutex> lock( mutex_ );
+
+    notEmpty_.wait( lock, [this]( ){ return closed_ || !values_.empty( ); } );
+
+    if( values_.empty( ) )
+    {
+        return false;
+    }
+
+    value = std::move( values_.front( ) );
+    values_.pop_front( );
+    notFull_.notify_one( );
+
+    return true;
+}
+
+template<typename T>
+inline void BoundedQueue<T>::close( )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+
+    closed_ = true;
+
+    notFull_.notify_all( );
+    notEmpty_.notify_all( );
+}
+
+} // namespace detail
+
+template<typename Iterator>
+inline std::string base64Encode( Iterator begin, Iterator end )
+{
+    constexpr size_t size = sizeof( decltype( *begin ) );
+
+    size_t rawBytes = static_cast<size_t>( std::distance( begin, end ) ) * size;
+
+    std::string result( encodedNumberOfBytes( rawBytes ), '\0' );
+
+    if( rawBytes != 0 )
+    {
+        detail::base64EncodeBytes( reinterpret_cast<const Byte*>( &( *begin ) ), rawBytes, &result[0] );
     }
 
     return result;
 }
 
+inline Base64Encoder::Base64Encoder( std::ostream& output, size_t chunkSize ) :
+    output_( output ), buffer_( (std::max)( chunkSize / 4, size_t { 1 } ) * 4 ), size_( 0 ), carrySize_( 0 )
+{ }
+
+inline void Base64Encoder::write( const void* data, size_t numberOfBytes )
+{
+    auto source = static_cast<const Byte*>( data );
+    auto end = source + numberOfBytes;
+
+    // Complete triplet carried over from previous call
+    if( carrySize_ != 0 )
+    {
+        while( carrySize_ < 3 && source < end )
+        {
+            carry_[carrySize_++] = *( source++ );
+        }
+
+        if( carrySize_ < 3 )
+        {
+            return;
+        }
+
+        if( size_ == buffer_.size( ) )
+        {
+            flush( );
+        }
+
+        size_ += detail::base64EncodeTriplets( carry_, 3, &buffer_[size_] ) / 3 * 4;
+        carrySize_ = 0;
+    }
+
+    while( end - source >= 3 )
+    {
+        if( size_ == buffer_.size( ) )
+        {
+            flush( );
+        }
+
+        auto available = static_cast<size_t>( end - source ) / 3;
+        auto capacity = ( buffer_.size( ) - size_ ) / 4;
+
+        auto consumed = detail::base64EncodeTriplets( source, 3 * (std::min)( available, capacity ), &buffer_[size_] );
+
+        source += consumed;
+        size_ += consumed / 3 * 4;
+    }
+
+    while( source < end )
+    {
+        carry_[carrySize_++] = *( source++ );
+    }
+}
+
+inline void Base64Encoder::finish( )
+{
+    if( carrySize_ != 0 )
+    {
+        if( size_ == buffer_.size( ) )
+        {
+            flush( );
+        }
+
+        detail::base64EncodeBytes( carry_, carrySize_, &buffer_[size_] );
+
+        size_ += 4;
+        carrySize_ = 0;
+    }
+
+    flush( );
+}
+
+inline void Base64Encoder::flush( )
+{
+    output_.write( buffer_.data( ), static_cast<std::streamsize>( size_ ) );
+
+    size_ = 0;
+}
+
 // http://www.cplusplus.com/forum/beginner/51572/
 inline size_t encodedNumberOfBytes( size_t rawNumberOfBytes )
 {
@@ -12,6 +12,7 @@
 
 #include "vtu11/inc/utilities.hpp"
 
+#include <cmath>
 #include <limits>
 #include <algorithm>
 
@@ -42,26 +43,184 @@ StringStringMap writeDataSetHeader( Writer&& writer,
     return attributes;
 }
 
+// Passes the options to writers that support them
+template<typename Writer> inline
+auto setDataArrayOptions( Writer& writer, const DataArrayOptions& options, int ) 
+    -> decltype( writer.setDataArrayOptions( options ) )
+{
+    return writer.setDataArrayOptions( options );
+}
+
+template<typename Writer> inline
+void setDataArrayOptions( Writer&, const DataArrayOptions&, long )
+{ }
+
+template<typename T> inline
+size_t numberOfBytes( const std::vector<T>& data )
+{
+    return data.size( ) * sizeof( T );
+}
+
+// Passes the uncompressed size of all data sets to writers that use it
+template<typename Writer> inline
+auto setTotalNumberOfBytes( Writer& writer, size_t numberOfBytes, int ) 
+    -> decltype( writer.setTotalNumberOfBytes( numberOfBytes ) )
+{
+    return writer.setTotalNumberOfBytes( numberOfBytes );
+}
+
+template<typename Writer> inline
+void setTotalNumberOfBytes( Writer&, size_t, long )
+{ }
+
+// Returns the alignment of the appended data for writers that support it
+template<typename Writer> inline
+auto appendedAlignment( const Writer& writer, int ) -> decltype( size_t { writer.alignment } )
+{
+    return writer.alignment;
+}
+
+template<typename Writer> inline
+size_t appendedAlignment( const Writer&, long )
+{
+    return 1;
+}
+
+// Options for the mesh arrays from mesh generators that provide them
+template<typename MeshGenerator> inline
+auto meshDataArrayOptions( MeshGenerator& mesh, int ) -> decltype( DataArrayOptions { mesh.dataArrayOptions( ) } )
+{
+    return mesh.dataArrayOptions( );
+}
+
+template<typename MeshGenerator> inline
+DataArrayOptions meshDataArrayOptions( MeshGenerator&, long )
+{
+    return DataArrayOptions { };
+}
+
+// Passes the file name to writers that can write the appended data directly to the file
+template<typename Writer> inline
+auto writeAppended( Writer& writer, std::ostream& output, const std::string& filename, int )
+    -> decltype( writer.writeAppended( output, filename ) )
+{
+    return writer.writeAppended( output, filename );
+}
+
+template<typename Writer> inline
+void writeAppended( Writer& writer, std::ostream& output, const std::string&, long )
+{
+    writer.writeAppended( output );
+}
+
+// Passes the stream position of the offset value to writers that patch it later
+template<typename Writer> inline
+auto writeAppendedTag( Writer& writer, std::ostream& output, const StringStringMap& attributes, int )
+    -> decltype( writer.setOffsetPosition( std::streamoff { } ) )
+{
+    std::streamoff offsetPosition = -1;
+
+    detail::writeTag( output, "DataArray", attributes, "/>", "offset", &offsetPosition );
+
+    return writer.setOffsetPosition( offsetPosition );
+}
+
+template<typename Writer> inline
+void writeAppendedTag( Writer&, std::ostream& output, const StringStringMap& attributes, long )
+{
+    writeEmptyTag( output, "DataArray", attributes );
+}
+
+// Writes the data converted to Target for writers that support it
+template<typename Target, typename Writer, typename DataType> inline
+auto writeConverted( Writer& writer, std::ostream& output, const std::vector<DataType>& data, int )
+    -> decltype( writer.template writeConverted<Target>( output, data ) )
+{
+    return writer.template writeConverted<Target>( output, data );
+}
+
+template<typename Target, typename Writer, typename DataType> inline
+void writeConverted( Writer&, std::ostream&, const std::vector<DataType>&, long )
+{
+    VTU11_THROW( "Writer does not support converting data arrays to " + dataTypeString<Target>( ) + "." );
+}
+
+// Integers must not change when converting them back
+template<typename Target, typename T> inline
+typename std::enable_if<std::numeric_limits<T>::is_integer, bool>::type outOfRange( T value )
+{
+    return static_cast<T>( static_cast<Target>( value ) ) != value;
+}
+
+// Infinity and NaN are written as they are
+template<typename Target, typename T> inline
+typename std::enable_if<!std::numeric_limits<T>::is_integer, bool>::type outOfRange( T value )
+{
+    return std::isfinite( value ) && std::abs( value ) > static_cast<T>( (std::numeric_limits<Target>::max)( ) );
+}
+
+template<typename Target, typename T> inline
+void checkRange( const std::vector<T>& data, const std::string& name )
+{
+    for( size_t i = 0; i < data.size( ); ++i )
+    {
+        VTU11_CHECK( !outOfRange<Target>( data[i] ), "Cannot write data array \"" + ( name.empty( ) ? "Points" : name ) +
+                     "\" as " + dataTypeString<Target>( ) + ": value " + std::to_string( data[i] ) +
+                     " at index " + std::to_string( i ) + " is out of range." );
+    }
+}
+
+template<typename DataType, typename Writer, typename WriteData> inline
+void writeDataArray( Writer& writer,
+                     std::ostream& output,
+                     const std::string& name,
+                     size_t ncomponents,
+                     WriteData&& writeData )
+{
+    auto attributes = writeDataSetHeader<DataType>( writer, name, ncomponents );
+
+    if( attributes["format"] != "appended" )
+    {
+        ScopedXmlTag dataArrayTag( output, "DataArray", attributes );
+
+        writeData( );
+    }
+    else
+    {
+        writeAppendedTag( writer, output, attributes, 0 );
+
+        writeData( );
+    }
+}
+
 template<typename Writer, typename DataType> inline
 void writeDataSet( Writer& writer,
                    std::ostream& output,
                    const std::string& name,
                    size_t ncomponents,
-                   const std::vector<DataType>& data )
+                   const std::vector<DataType>& data,
+                   const DataArrayOptions& options = DataArrayOptions { } )
 {
-    auto attributes = writeDataSetHeader<DataType>( writer, name, ncomponents );
+    using Narrowed = typename NarrowedType<DataType>::type;
 
-    if( attributes["format"] != "appended" )
+    setDataArrayOptions( writer, options, 0 );
+
+    if( options.narrow && !std::is_same<Narrowed, DataType>::value )
     {
-        ScopedXmlTag dataArrayTag( output, "DataArray", attributes );
+        // Before writing anything, since appended data is converted at the end
+        checkRange<Narrowed>( data, name );
 
-        writer.writeData( output, data );
+        writeDataArray<Narrowed>( writer, output, name, ncomponents, [&]( )
+        { 
+            writeConverted<Narrowed>( writer, output, data, 0 ); 
+        } );
     }
     else
     {
-        writeEmptyTag( output, "DataArray", attributes );
-
-        writer.writeData( output, data );
+        writeDataArray<DataType>( writer, output, name, ncomponents, [&]( )
+        { 
+            writer.writeData( output, data );
+        } );
     }
 }
 
@@ -77,7 +236,7 @@ void writeDataSets( const std::vector<DataSetInfo>& dataSetInfo,
         if( std::get<1>( metadata ) == type )
         {
             detail::writeDataSet( writer, output, std::get<0>( metadata ), 
-                std::get<2>( metadata ), dataSetData[iDataset] );
+                std::get<2>( metadata ), dataSetData[iDataset], metadata.options );
         }
     }
 }
@@ -92,8 +251,9 @@ void writeDataSetPVtuHeaders( const std::vector<DataSetInfo>& dataSetInfo,
 
         if( std::get<1>( metadata ) == type )
         {
-            auto attributes = detail::writeDataSetHeader<double>( writer, 
-               std::get<0>( metadata ), std::get<2>( metadata ) );
+            auto attributes = metadata.options.narrow ?
+                detail::writeDataSetHeader<NarrowedType<double>::type>( writer, std::get<0>( metadata ), std::get<2>( metadata ) ) :
+                detail::writeDataSetHeader<double>( writer, std::get<0>( metadata ), std::get<2>( metadata ) );
 
             writeEmptyTag( output, "PDataArray", attributes );
         }
@@ -140,6 +300,21 @@ void writeVtu( const std::string& filename,
                const std::vector<DataSetData>& dataSetData,
                Writer&& writer )
 {
+    // Mesh arrays may be reused across files
+    auto meshOptions = meshDataArrayOptions( mesh, 0 );
+
+    meshOptions.cache = true;
+
+    size_t totalNumberOfBytes = numberOfBytes( mesh.points( ) ) + numberOfBytes( mesh.connectivity( ) ) + 
+                                numberOfBytes( mesh.offsets( ) ) + numberOfBytes( mesh.types( ) );
+
+    for( const auto& data : dataSetData )
+    {
+        totalNumberOfBytes += numberOfBytes( data );
+    }
+
+    setTotalNumberOfBytes( writer, totalNumberOfBytes, 0 );
+
     detail::writeVTUFile( filename, "UnstructuredGrid", writer, [&]( std::ostream& output )
     {
         {
@@ -171,16 +346,16 @@ void writeVtu( const std::string& filename,
                 {
                     ScopedXmlTag pointsTag( output, "Points", { } );
 
-                    detail::writeDataSet( writer, output, "", 3, mesh.points( ) );
+                    detail::writeDataSet( writer, output, "", 3, mesh.points( ), meshOptions );
 
                 } // Points
 
                 {
                     ScopedXmlTag pointsTag( output, "Cells", { } );
 
-                    detail::writeDataSet( writer, output, "connectivity", 1, mesh.connectivity( ) );
-                    detail::writeDataSet( writer, output, "offsets", 1, mesh.offsets( ) );
-                    detail::writeDataSet( writer, output, "types", 1, mesh.types( ) );
+                    detail::writeDataSet( writer, output, "connectivity", 1, mesh.connectivity( ), meshOptions );
+                    detail::writeDataSet( writer, output, "offsets", 1, mesh.offsets( ), meshOptions );
+                    detail::writeDataSet( writer, output, "types", 1, mesh.types( ), meshOptions );
 
                 } // Cells
 
@@ -193,9 +368,21 @@ void writeVtu( const std::string& filename,
         {
             ScopedXmlTag appendedDataTag( output, "AppendedData", appendedAttributes );
 
+            // Offsets are relative to the character after the underscore, so we 
+            // align it in the file using spaces, which readers skip until the '_'
+            auto alignment = appendedAlignment( writer, 0 );
+            auto position = output.tellp( );
+
+            if( alignment > 1 && position != std::streampos( -1 ) )
+            {
+                auto begin = static_cast<size_t>( position ) + 1;
+
+                output << std::string( detail::alignOffset( begin, 0, alignment ) - begin, ' ' );
+            }
+
             output << "_";
 
-            writer.writeAppended( output );
+            writeAppended( writer, output, filename, 0 );
 
         } // AppendedData     
 
@@ -229,6 +416,38 @@ void writeVtu( const std::string& filename,
     {
         detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Base64BinaryAppendedWriter { } );
     }
+    else if( mode == "base64inlinecompressed" )
+    {
+        #ifdef VTU11_ENABLE_ZLIB
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, CompressedBase64Writer { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Base64BinaryWriter { } );
+        #endif
+    }
+    else if( mode == "base64appendedcompressed" )
+    {
+        #ifdef VTU11_ENABLE_ZLIB
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, CompressedBase64AppendedWriter { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Base64BinaryAppendedWriter { } );
+        #endif
+    }
+    else if( mode == "base64inlinelz4compressed" )
+    {
+        #ifdef VTU11_ENABLE_LZ4
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Lz4CompressedBase64Writer { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Base64BinaryWriter { } );
+        #endif
+    }
+    else if( mode == "base64appendedlz4compressed" )
+    {
+        #ifdef VTU11_ENABLE_LZ4
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Lz4CompressedBase64AppendedWriter { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Base64BinaryAppendedWriter { } );
+        #endif
+    }
     else if( mode == "rawbinary" )
     {
         detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, RawBinaryAppendedWriter { } );
@@ -241,6 +460,30 @@ void writeVtu( const std::string& filename,
             detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, RawBinaryAppendedWriter { } );
         #endif
     }
+    else if( mode == "rawbinarystreamingcompressed" )
+    {
+        #ifdef VTU11_ENABLE_ZLIB
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, StreamingCompressedRawBinaryAppendedWriter { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, RawBinaryAppendedWriter { } );
+        #endif
+    }
+    else if( mode == "rawbinarylz4compressed" )
+    {
+        #ifdef VTU11_ENABLE_LZ4
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, Lz4CompressedRawBinaryAppendedWriter { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, RawBinaryAppendedWriter { } );
+        #endif
+    }
+    else if( mode == "rawbinarylzmacompressed" )
+    {
+        #ifdef VTU11_ENABLE_LZMA
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, LzmaCompressedRawBinaryAppendedWriter { } );
+        #else
+            detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, RawBinaryAppendedWriter { } );
+        #endif
+    }
     else
     {
         VTU11_THROW( "Invalid write mode: \"" + writeMode + "\"." );
@@ -248,6 +491,17 @@ void writeVtu( const std::string& filename,
 
 } // writeVtu
 
+template<typename MeshGenerator, typename Writer> inline
+typename std::enable_if<!std::is_convertible<Writer, std::string>::value>::type
+    writeVtu( const std::string& filename,
+              MeshGenerator& mesh,
+              const std::vector<DataSetInfo>& dataSetInfo,
+              const std::vector<DataSetData>& dataSetData,
+              Writer&& writer )
+{
+    detail::writeVtu( filename, mesh, dataSetInfo, dataSetData, writer );
+}
+
 namespace detail
 {
 
@@ -257,12 +511,26 @@ struct PVtuDummyWriter
     void addDataAttributes( StringStringMap& ) { }
 };
 
+inline std::string partitionFilename( const std::string& path,
+                                      const std::string& baseName,
+                                      size_t fileId )
+{
+    auto vtuname = baseName + "_" + std::to_string( fileId ) + ".vtu";
+
+    auto fullname = vtu11fs::path { path } / 
+                    vtu11fs::path { baseName } / 
+                    vtu11fs::path { vtuname };
+
+    return fullname.string( );
+}
+
 } // detail
 
 inline void writePVtu( const std::string& path,
                        const std::string& baseName,
                        const std::vector<DataSetInfo>& dataSetInfo,
-                       const size_t numberOfFiles )
+                       const size_t numberOfFiles,
+                       const DataArrayOptions& meshOptions )
 {
     auto directory = vtu11fs::path { path } / baseName;
     auto pvtufile = vtu11fs::path { path } / ( baseName + ".pvtu" );
@@ -299,7 +567,9 @@ inline void writePVtu( const std::string& path,
 
         {
             ScopedXmlTag pPointsTag( output, "PPoints", { } );
-            StringStringMap attributes = { { "type", dataTypeString<double>( ) }, { "NumberOfComponents", "3" } };
+            auto pointsType = meshOptions.narrow ? dataTypeString<detail::NarrowedType<double>::type>( ) : dataTypeString<double>( );
+
+            StringStringMap attributes = { { "type", pointsType }, { "NumberOfComponents", "3" } };
 
             writer.addDataAttributes( attributes );
 
@@ -328,13 +598,21 @@ void writePartition( const std::string& path,
                      size_t fileId,
                      const std::string& writeMode )
 {
-    auto vtuname = baseName + "_" + std::to_string( fileId ) + ".vtu";
+    writeVtu( detail::partitionFilename( path, baseName, fileId ), mesh, dataSetInfo, dataSetData, writeMode );
 
-    auto fullname = vtu11fs::path { path } / 
-                    vtu11fs::path { baseName } / 
-                    vtu11fs::path { vtuname };
+} // writePartition
 
-    writeVtu( fullname.string( ), mesh, dataSetInfo, dataSetData, writeMode );
+template<typename MeshGenerator, typename Writer> inline
+typename std::enable_if<!std::is_convertible<Writer, std::string>::value>::type
+    writePartition( const std::string& path,
+                    const std::string& baseName,
+                    MeshGenerator& mesh,
+                    const std::vector<DataSetInfo>& dataSetInfo,
+                    const std::vector<DataSetData>& dataSetData,
+                    size_t fileId,
+                    Writer&& writer )
+{
+    writeVtu( detail::partitionFilename( path, baseName, fileId ), mesh, dataSetInfo, dataSetData, writer );
 
 } // writePartition
 
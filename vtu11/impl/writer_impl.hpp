@@ -12,99 +12,379 @@
 
 #include "vtu11/inc/utilities.hpp"
 
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 
+// Positioned writes for the raw appended data
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define VTU11_USE_PWRITE
+#endif
+
+#if defined(__cplusplus) && __cplusplus >= 201703L
+    #if __has_include(<charconv>)
+        #include <charconv>
+    #endif
+#endif
+
+// Floating point std::to_chars is not available in all C++17 standard libraries
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    #define VTU11_USE_TO_CHARS
+#endif
+
 namespace vtu11
 {
 namespace detail
 {
 
-template<typename T> inline
-void writeNumber( char (&)[64], T )
+//! Returns n if format is "%.<n>g", which std::to_chars can reproduce, otherwise -1
+inline int generalFormatPrecision( const char* format )
 {
-    VTU11_THROW( "Invalid data type." );
+    if( std::strncmp( format, "%.", 2 ) != 0 )
+    {
+        return -1;
+    }
+
+    char* end;
+
+    long precision = std::strtol( format + 2, &end, 10 );
+
+    bool valid = end != format + 2 && std::strcmp( end, "g" ) == 0 && precision <= 17;
+
+    return valid ? static_cast<int>( precision ) : -1;
 }
 
-#define VTU11_WRITE_NUMBER_SPECIALIZATION( string, type )     \
-template<> inline                                             \
-void writeNumber<type>( char (&buffer)[64], type value )      \
-{                                                             \
-    std::snprintf( buffer, sizeof( buffer ), string, value ); \
+//! Writes the decimal digits of value, two per step, and returns their number
+inline size_t formatInteger( char* target, unsigned long long value )
+{
+    static const char digitPairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    char buffer[20];
+
+    char* end = buffer + sizeof( buffer );
+    char* begin = end;
+
+    while( value >= 100 )
+    {
+        begin -= 2;
+
+        std::memcpy( begin, digitPairs + 2 * ( value % 100 ), 2 );
+
+        value /= 100;
+    }
+
+    if( value >= 10 )
+    {
+        begin -= 2;
+
+        std::memcpy( begin, digitPairs + 2 * value, 2 );
+    }
+    else
+    {
+        *( --begin ) = static_cast<char>( '0' + value );
+    }
+
+    auto length = static_cast<size_t>( end - begin );
+
+    std::memcpy( target, begin, length );
+
+    return length;
 }
 
-VTU11_WRITE_NUMBER_SPECIALIZATION( VTU11_ASCII_FLOATING_POINT_FORMAT, double )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%lld", long long int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%ld" , long int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%d"  , int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%hd" , short )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%hhd", char )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%llu", unsigned long long int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%ld" , unsigned long int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%d"  , unsigned int )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%hd" , unsigned short )
-VTU11_WRITE_NUMBER_SPECIALIZATION( "%hhd", unsigned char )
+inline size_t formatInteger( char* target, long long value )
+{
+    if( value < 0 )
+    {
+        *target = '-';
 
-} // namespace detail
+        // Negate after converting, which is also defined for the smallest value
+        return 1 + formatInteger( target + 1, 0ull - static_cast<unsigned long long>( value ) );
+    }
 
+    return formatInteger( target, static_cast<unsigned long long>( value ) );
+}
+
+// Reads back a formatted value with the precision of its type
+inline double parseNumber( const char* source, double )
+{
+    return std::strtod( source, nullptr );
+}
+
+inline float parseNumber( const char* source, float )
+{
+    return std::strtof( source, nullptr );
+}
+
+/*! Formats with the given number of significant digits or, for AsciiRoundTrip,
+ *  with the shortest representation that reads back as the same T value.
+ */
 template<typename T>
-inline void AsciiWriter::writeData( std::ostream& output,
-                                    const std::vector<T>& data )
+inline size_t formatSignificantDigits( char* target, T value, int digits )
 {
-    char buffer[64];
+    #ifdef VTU11_USE_TO_CHARS
+    auto result = digits == DataArrayOptions::AsciiRoundTrip ? 
+        std::to_chars( target, target + 64, value ) :
+        std::to_chars( target, target + 64, value, std::chars_format::general, digits );
+
+    return static_cast<size_t>( result.ptr - target );
+    #else
+    if( digits != DataArrayOptions::AsciiRoundTrip )
+    {
+        return static_cast<size_t>( std::snprintf( target, 64, "%.*g", digits, static_cast<double>( value ) ) );
+    }
+
+    int length = 0;
 
-    for( auto value : data )
+    // Shortest of digits10 to max_digits10 significant digits that reads back exactly
+    for( digits = std::numeric_limits<T>::digits10; digits <= std::numeric_limits<T>::max_digits10; ++digits )
     {
-        detail::writeNumber( buffer, value );
+        length = std::snprintf( target, 64, "%.*g", digits, static_cast<double>( value ) );
 
-        output << buffer << " ";
+        if( parseNumber( target, value ) == value )
+        {
+            break;
+        }
     }
 
-    output << "\n";
+    return static_cast<size_t>( length );
+    #endif
 }
 
-template<>
-inline void AsciiWriter::writeData( std::ostream& output,
-                                    const std::vector<std::int8_t>& data )
+//! Significant digits chosen at runtime, e.g. by DataArrayOptions::asciiPrecision
+struct RuntimeSignificantDigits
 {
-  for( auto value : data )
-  {
-    // will otherwise interpret uint8 as char and output nonsense instead
-  	// changed the datatype from unsigned to int
-      output << static_cast<int>( value ) << " ";
-  }
+    size_t operator( )( char* target, double value ) const
+    {
+        return formatSignificantDigits( target, value, digits );
+    }
 
-  output << "\n";
+    int digits;
+};
+
+// SFINAE if signed integer
+template<typename T, typename Precision> inline
+typename std::enable_if<std::numeric_limits<T>::is_integer && 
+                        std::numeric_limits<T>::is_signed, size_t>::type 
+    formatNumber( char* target, T value, const Precision& )
+{
+    return formatInteger( target, static_cast<long long>( value ) );
+}
+
+// SFINAE if unsigned integer
+template<typename T, typename Precision> inline
+typename std::enable_if<std::numeric_limits<T>::is_integer &&
+                       !std::numeric_limits<T>::is_signed, size_t>::type 
+    formatNumber( char* target, T value, const Precision& )
+{
+    return formatInteger( target, static_cast<unsigned long long>( value ) );
+}
+
+// SFINAE if double or float
+template<typename T, typename Precision> inline
+typename std::enable_if<std::is_same<T, double>::value || 
+                        std::is_same<T, float>::value, size_t>::type 
+    formatNumber( char* target, T value, const Precision& precision )
+{
+    // Float values are widened by policies that only format double
+    return precision( target, value );
+}
+
+//! Replaces target by the values converted to Target and formatted, each followed by a space
+template<typename Target, typename T, typename Precision> inline
+void formatNumbers( const T* begin, const T* end, std::vector<char>& target, const Precision& precision )
+{
+    target.resize( static_cast<size_t>( end - begin ) * 65 );
+
+    size_t size = 0;
+
+    for( auto value = begin; value < end; ++value )
+    {
+        size += formatNumber( target.data( ) + size, static_cast<Target>( *value ), precision );
+
+        target[size++] = ' ';
+    }
+
+    target.resize( size );
 }
 
-inline void AsciiWriter::writeAppended( std::ostream& )
+} // namespace detail
+
+inline FormatStringPrecision::FormatStringPrecision( ) :
+    digits_( detail::generalFormatPrecision( VTU11_ASCII_FLOATING_POINT_FORMAT ) )
+{ }
+
+inline size_t FormatStringPrecision::operator( )( char* target, double value ) const
 {
+    if( digits_ >= 0 )
+    {
+        return detail::formatSignificantDigits( target, value, digits_ );
+    }
+
+    int length = std::snprintf( target, 64, VTU11_ASCII_FLOATING_POINT_FORMAT, value );
 
+    // Truncated like before if a custom format produces more chars
+    return static_cast<size_t>( (std::min)( length, 63 ) );
 }
 
-inline void AsciiWriter::addHeaderAttributes( StringStringMap& )
+template<int Digits>
+inline size_t SignificantDigits<Digits>::operator( )( char* target, double value ) const
 {
+    return detail::formatSignificantDigits( target, value, Digits );
 }
 
-inline void AsciiWriter::addDataAttributes( StringStringMap& attributes )
+inline size_t RoundTripPrecision::operator( )( char* target, double value ) const
+{
+    return detail::formatSignificantDigits( target, value, DataArrayOptions::AsciiRoundTrip );
+}
+
+inline size_t RoundTripPrecision::operator( )( char* target, float value ) const
+{
+    return detail::formatSignificantDigits( target, value, DataArrayOptions::AsciiRoundTrip );
+}
+
+template<typename Precision>
+template<typename T>
+inline void BasicAsciiWriter<Precision>::writeData( std::ostream& output,
+                                                    const std::vector<T>& data )
+{
+    writeConverted<T>( output, data );
+}
+
+template<typename Precision>
+template<typename Target, typename T>
+inline void BasicAsciiWriter<Precision>::writeConverted( std::ostream& output,
+                                                         const std::vector<T>& data )
+{
+    int digits = dataArrayOptions.asciiPrecision;
+
+    // Select the formatting loop once per data array
+    if( digits == DataArrayOptions::WriterAsciiPrecision )
+    {
+        writeFormatted<Target>( output, data, precision );
+    }
+    else if( digits == DataArrayOptions::AsciiRoundTrip )
+    {
+        writeFormatted<Target>( output, data, RoundTripPrecision { } );
+    }
+    else
+    {
+        VTU11_CHECK( digits >= 1 && digits <= 17, "Invalid ascii precision " + std::to_string( digits ) + 
+                     " (must be between 1 and 17 significant digits)." );
+
+        writeFormatted<Target>( output, data, detail::RuntimeSignificantDigits { digits } );
+    }
+}
+
+template<typename Precision>
+template<typename Target, typename T, typename ArrayPrecision>
+inline void BasicAsciiWriter<Precision>::writeFormatted( std::ostream& output,
+                                                         const std::vector<T>& data,
+                                                         const ArrayPrecision& arrayPrecision )
+{
+    size_t numberOfChunks = ( data.size( ) + ChunkSize - 1 ) / ChunkSize;
+    size_t threads = detail::resolveNumberOfThreads( numberOfThreads );
+    size_t chunksPerRound = threads > 1 ? threads * ChunksPerThread : 1;
+
+    // Format chunks concurrently into separate buffers, then write them in order
+    std::vector<std::vector<char>> buffers( (std::min)( chunksPerRound, numberOfChunks ) );
+
+    for( size_t firstChunk = 0; firstChunk < numberOfChunks; firstChunk += chunksPerRound )
+    {
+        size_t numberOfRoundChunks = (std::min)( chunksPerRound, numberOfChunks - firstChunk );
+
+        std::atomic<size_t> nextChunk { 0 };
+
+        auto formatChunks = [&]( )
+        {
+            for( size_t iChunk = nextChunk++; iChunk < numberOfRoundChunks; iChunk = nextChunk++ )
+            {
+                size_t begin = ( firstChunk + iChunk ) * ChunkSize;
+                size_t end = (std::min)( begin + ChunkSize, data.size( ) );
+
+                detail::formatNumbers<Target>( data.data( ) + begin, data.data( ) + end, buffers[iChunk], arrayPrecision );
+            }
+        };
+
+        if( numberOfRoundChunks > 1 )
+        {
+            detail::runInParallel( (std::min)( threads, numberOfRoundChunks ), formatChunks );
+        }
+        else
+        {
+            formatChunks( );
+        }
+
+        for( size_t iChunk = 0; iChunk < numberOfRoundChunks; ++iChunk )
+        {
+            output.write( buffers[iChunk].data( ), static_cast<std::streamsize>( buffers[iChunk].size( ) ) );
+        }
+    }
+
+    output << "\n";
+}
+
+template<typename Precision>
+inline void BasicAsciiWriter<Precision>::writeAppended( std::ostream& )
+{
+
+}
+
+template<typename Precision>
+inline void BasicAsciiWriter<Precision>::addHeaderAttributes( StringStringMap& )
+{
+}
+
+template<typename Precision>
+inline void BasicAsciiWriter<Precision>::addDataAttributes( StringStringMap& attributes )
 {
   attributes["format"] = "ascii";
 }
 
-inline StringStringMap AsciiWriter::appendedAttributes( )
+template<typename Precision>
+inline StringStringMap BasicAsciiWriter<Precision>::appendedAttributes( )
 {
   return { };
 }
 
+template<typename Precision>
+inline void BasicAsciiWriter<Precision>::setDataArrayOptions( const DataArrayOptions& options )
+{
+  dataArrayOptions = options;
+}
+
 // ----------------------------------------------------------------
 
 template<typename T>
 inline void Base64BinaryWriter::writeData( std::ostream& output,
                                            const std::vector<T>& data )
 {
-  HeaderType numberOfBytes = data.size( ) * sizeof( T );
+  writeConverted<T>( output, data );
+}
+
+template<typename Target, typename T>
+inline void Base64BinaryWriter::writeConverted( std::ostream& output,
+                                                const std::vector<T>& data )
+{
+  auto array = detail::arrayBytes<Target>( data );
+
+  HeaderType numberOfBytes = array.numberOfBytes;
 
   output << base64Encode( &numberOfBytes, &numberOfBytes + 1 );
-  output << base64Encode( data.begin( ), data.end( ) );
+
+  Base64Encoder encoder( output );
+
+  detail::forEachChunk( array, [&]( const Byte* chunk, size_t size ){ encoder.write( chunk, size ); } );
+
+  encoder.finish( );
 
   output << "\n";
 }
@@ -132,28 +412,35 @@ inline StringStringMap Base64BinaryWriter::appendedAttributes( )
 // ----------------------------------------------------------------
 
 template<typename T>
-inline void Base64BinaryAppendedWriter::writeData( std::ostream&,
+inline void Base64BinaryAppendedWriter::writeData( std::ostream& output,
                                                    const std::vector<T>& data )
 {
-  HeaderType rawBytes = data.size( ) * sizeof( T );
+  writeConverted<T>( output, data );
+}
 
-  appendedData.emplace_back( reinterpret_cast<const char*>( &data[0] ), rawBytes );
+template<typename Target, typename T>
+inline void Base64BinaryAppendedWriter::writeConverted( std::ostream&,
+                                                        const std::vector<T>& data )
+{
+  appendedData.push_back( detail::arrayBytes<Target>( data ) );
 
-  offset += encodedNumberOfBytes( rawBytes + sizeof( HeaderType ) );
+  offset += encodedNumberOfBytes( appendedData.back( ).numberOfBytes + sizeof( HeaderType ) );
 }
 
 inline void Base64BinaryAppendedWriter::writeAppended( std::ostream& output )
 {
-  for( auto dataSet : appendedData )
+  Base64Encoder encoder( output );
+
+  for( const auto& dataSet : appendedData )
   {
-    // looks like header and data has to be encoded at once
-    std::vector<char> data( dataSet.second + sizeof( HeaderType ) );
+    HeaderType header = dataSet.numberOfBytes;
 
-    *reinterpret_cast<HeaderType*>( &data[0] ) = dataSet.second;
+    // looks like header and data has to be encoded at once
+    encoder.write( &header, sizeof( HeaderType ) );
 
-    std::copy( dataSet.first, dataSet.first + dataSet.second, &data[ sizeof( HeaderType ) ] );
+    detail::forEachChunk( dataSet, [&]( const Byte* chunk, size_t size ){ encoder.write( chunk, size ); } );
 
-    output << base64Encode( data.begin( ), data.end( ) );
+    encoder.finish( );
   }
 
   output << "\n";
@@ -175,37 +462,186 @@ inline StringStringMap Base64BinaryAppendedWriter::appendedAttributes( )
   return { { "encoding", "base64" } };
 }
 
+inline void Base64BinaryAppendedWriter::setTotalNumberOfBytes( size_t )
+{
+  offset = 0;
+
+  appendedData.clear( );
+}
+
 // ----------------------------------------------------------------
 
 template<typename T>
-inline void RawBinaryAppendedWriter::writeData( std::ostream&,
+inline void RawBinaryAppendedWriter::writeData( std::ostream& output,
                                                 const std::vector<T>& data )
 {
-  HeaderType rawBytes = data.size( ) * sizeof( T );
+  writeConverted<T>( output, data );
+}
 
-  appendedData.emplace_back( reinterpret_cast<const char*>( &data[0] ), rawBytes );
+template<typename Target, typename T>
+inline void RawBinaryAppendedWriter::writeConverted( std::ostream&,
+                                                     const std::vector<T>& data )
+{
+  appendedData.push_back( detail::arrayBytes<Target>( data ) );
 
-  offset += sizeof( HeaderType ) + rawBytes;
+  offset += sizeof( HeaderType ) + appendedData.back( ).numberOfBytes;
 }
 
 inline void RawBinaryAppendedWriter::writeAppended( std::ostream& output )
 {
-  for( auto dataSet : appendedData )
+  size_t position = 0;
+
+  for( const auto& dataSet : appendedData )
   {
-    const char* headerBegin = reinterpret_cast<const char*>( &dataSet.second );
+    // Same padding as in addDataAttributes
+    size_t padding = detail::alignOffset( position, sizeof( HeaderType ), alignment ) - position;
 
-    for( const char* ptr = headerBegin; ptr < headerBegin + sizeof( HeaderType ); ++ptr )
+    detail::writeZeros( output, padding );
+
+    HeaderType header = dataSet.numberOfBytes;
+
+    output.write( reinterpret_cast<const char*>( &header ), sizeof( HeaderType ) );
+
+    detail::forEachChunk( dataSet, [&]( const Byte* chunk, size_t size )
+    { 
+      output.write( reinterpret_cast<const char*>( chunk ), static_cast<std::streamsize>( size ) );
+    } );
+
+    position += padding + sizeof( HeaderType ) + dataSet.numberOfBytes;
+  }
+
+  output << "\n";
+}
+
+#ifdef VTU11_USE_PWRITE
+namespace detail
+{
+
+// Writes all bytes at position, continues after partial writes and interrupts
+inline bool pwriteAll( int file, const char* data, size_t numberOfBytes, off_t position )
+{
+    while( numberOfBytes != 0 )
     {
-      output << *ptr;
+        auto written = ::pwrite( file, data, numberOfBytes, position );
+
+        if( written < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += written;
+        position += written;
+        numberOfBytes -= static_cast<size_t>( written );
     }
 
-    for( const char* ptr = dataSet.first; ptr < dataSet.first + dataSet.second; ++ptr )
+    return true;
+}
+
+} // namespace detail
+#endif
+
+inline void RawBinaryAppendedWriter::writeAppended( std::ostream& output, const std::string& filename )
+{
+  #ifdef VTU11_USE_PWRITE
+  auto numberOfWritingThreads = detail::resolveNumberOfThreads( numberOfThreads );
+
+  output.flush( );
+
+  auto begin = output.tellp( );
+
+  if( numberOfWritingThreads > 1 && begin != std::streampos( -1 ) && output.good( ) )
+  {
+    struct Write
+    {
+      off_t position;
+      const detail::ArrayBytes* array;
+      size_t begin;
+      size_t size;
+    };
+
+    // Same layout as writeAppended( output ), the padding remains zero from resizing the file
+    std::vector<Write> writes;
+    std::vector<HeaderType> headers( appendedData.size( ) );
+    std::vector<detail::ArrayBytes> headerBytes( appendedData.size( ) );
+
+    size_t appendedBegin = static_cast<size_t>( begin ), position = 0;
+    size_t size = (std::max)( chunkSize, size_t { 1 } );
+
+    for( size_t iDataSet = 0; iDataSet < appendedData.size( ); ++iDataSet )
     {
-      output << *ptr;
+      const auto& dataSet = appendedData[iDataSet];
+
+      headers[iDataSet] = dataSet.numberOfBytes;
+      headerBytes[iDataSet] = { reinterpret_cast<const Byte*>( &headers[iDataSet] ), sizeof( HeaderType ), nullptr };
+
+      position = detail::alignOffset( position, sizeof( HeaderType ), alignment );
+
+      writes.push_back( { static_cast<off_t>( appendedBegin + position ), &headerBytes[iDataSet], 0, sizeof( HeaderType ) } );
+
+      position += sizeof( HeaderType );
+
+      for( size_t chunk = 0; chunk < dataSet.numberOfBytes; chunk += size )
+      {
+        writes.push_back( { static_cast<off_t>( appendedBegin + position + chunk ), 
+                            &dataSet, chunk, (std::min)( size, dataSet.numberOfBytes - chunk ) } );
+      }
+
+      position += dataSet.numberOfBytes;
     }
+
+    size_t end = appendedBegin + position;
+
+    int file = ::open( filename.c_str( ), O_WRONLY );
+
+    VTU11_CHECK( file != -1, "Failed to open file \"" + filename + "\" for writing appended data." );
+
+    bool success = ::ftruncate( file, static_cast<off_t>( end ) ) == 0;
+
+    std::atomic<size_t> nextWrite { 0 };
+    std::atomic<bool> failed { !success };
+
+    detail::runInParallel( (std::max)( (std::min)( numberOfWritingThreads, writes.size( ) ), size_t { 1 } ), [&]( )
+    {
+      // Converted arrays are converted chunk by chunk into this buffer
+      std::vector<Byte> buffer;
+
+      for( size_t iWrite = nextWrite++; iWrite < writes.size( ) && !failed; iWrite = nextWrite++ )
+      {
+        const auto& write = writes[iWrite];
+
+        if( write.array->convert != nullptr )
+        {
+          buffer.resize( write.size );
+        }
+
+        auto data = reinterpret_cast<const char*>( write.array->bytes( write.begin, write.size, buffer.data( ) ) );
+
+        if( !detail::pwriteAll( file, data, write.size, write.position ) )
+        {
+          failed = true;
+        }
+      }
+    } );
+
+    success = ::close( file ) == 0 && !failed;
+
+    VTU11_CHECK( success, "Failed to write appended data to file \"" + filename + "\"." );
+
+    output.seekp( static_cast<std::streamoff>( end ) );
+    output << "\n";
+
+    return;
   }
+  #else
+  static_cast<void>( filename );
+  #endif
 
-  output << "\n";
+  writeAppended( output );
 }
 
 inline void RawBinaryAppendedWriter::addHeaderAttributes( StringStringMap& attributes )
@@ -215,6 +651,8 @@ inline void RawBinaryAppendedWriter::addHeaderAttributes( StringStringMap& attri
 
 inline void RawBinaryAppendedWriter::addDataAttributes( StringStringMap& attributes )
 {
+  offset = detail::alignOffset( offset, sizeof( HeaderType ), alignment );
+
   attributes["format"] = "appended";
   attributes["offset"] = std::to_string( offset );
 }
@@ -224,6 +662,13 @@ inline StringStringMap RawBinaryAppendedWriter::appendedAttributes( )
   return { { "encoding", "raw" } };
 }
 
+inline void RawBinaryAppendedWriter::setTotalNumberOfBytes( size_t )
+{
+  offset = 0;
+
+  appendedData.clear( );
+}
+
 } // namespace vtu11
 
 #endif // VTU11_WRITER_IMPL_HPP
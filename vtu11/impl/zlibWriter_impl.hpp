@@ -13,146 +13,88 @@
 #ifdef VTU11_ENABLE_ZLIB
 
 #include "vtu11/inc/utilities.hpp"
-#include "zlib.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace vtu11
 {
-namespace detail
-{
 
-template<typename T>
-std::vector<HeaderType> zlibCompressData( const std::vector<T>& data,
-                                          std::vector<std::vector<Byte>>& targetBlocks,
-                                          size_t blockSize = 32768 ) // 2^15
+inline ZlibCompressor::ZlibCompressor( int compressionLevel )
 {
-  using IntType = uLong;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
 
-  // Somewhere in vtu11/inc/filesystem.hpp, with MSVC, max is defined as macro. This pre-
-  // vents us from using std::numeric_limits<T>::max( ), so we turn off these checks. 
-  #ifndef max
-  if( data.size( ) > std::numeric_limits<IntType>::max( ) ||
-      blockSize > std::numeric_limits<IntType>::max( ) )
-  {
-      throw std::runtime_error( "Size too large for uLong zlib type." );
-  }
-  #endif
-
-  std::vector<HeaderType> header( 3, 0 );
+  int errorCode = deflateInit( &stream, compressionLevel );
 
-  if( data.empty( ) )
+  if( errorCode != Z_OK )
   {
-    return header;
+    throw std::runtime_error( "Error initializing zlib compression with level " +
+      std::to_string( compressionLevel ) + " (code " + std::to_string( errorCode ) + ")." );
   }
+}
 
-  auto blocksize = static_cast<IntType>( blockSize );
-
-  auto compressedBuffersize = compressBound( blocksize );
-
-  Byte* buffer = new Byte[compressedBuffersize];
-  Byte* currentByte = const_cast<Byte*>( reinterpret_cast<const Byte*>( &data[0] ) );
-  
-  IntType numberOfBytes = static_cast<IntType>( data.size( ) ) * sizeof( T );
-  IntType numberOfBlocks = ( numberOfBytes - 1 ) / blocksize + 1;
+inline ZlibCompressor::~ZlibCompressor( )
+{
+  deflateEnd( &stream );
+}
 
-  auto compressBlock = [&]( IntType numberOfBytesInBlock )
+inline size_t ZlibCompressor::compressBound( size_t numberOfBytes )
+{
+  // The block (avail_in) and its compressed size (avail_out) must both fit into uInt,
+  // which also excludes an overflow of the bound for a 32 bit uLong
+  if( numberOfBytes > (std::numeric_limits<uInt>::max)( ) )
   {
-      IntType compressedLength = compressedBuffersize;
-
-    int errorCode = compress( buffer, &compressedLength, currentByte, numberOfBytesInBlock );
-
-    if( errorCode != Z_OK )
-    {
-      delete[] buffer;
-
-      throw std::runtime_error( "Error in zlib compression (code " + std::to_string( errorCode ) + ")." );
-    }
-
-    targetBlocks.emplace_back( buffer, buffer + compressedLength );
-    header.push_back( compressedLength );
+      throw std::runtime_error( "Size too large for uInt zlib type." );
+  }
 
-    currentByte += numberOfBytesInBlock;
-  };
+  uLong bound = ::compressBound( static_cast<uLong>( numberOfBytes ) );
 
-  for( IntType iBlock = 0; iBlock < numberOfBlocks - 1; ++iBlock )
+  if( bound < numberOfBytes || bound > (std::numeric_limits<uInt>::max)( ) )
   {
-    compressBlock( static_cast<IntType>( blocksize ) );
+      throw std::runtime_error( "Compressed size too large for uInt zlib type." );
   }
 
-  IntType remainder = numberOfBytes - ( numberOfBlocks - 1 ) * blocksize;
-
-  compressBlock( remainder );
-
-  delete[] buffer;
-
-  header[0] = header.size( ) - 3;
-  header[1] = blocksize;
-  header[2] = remainder;
-
-  return header;
+  return static_cast<size_t>( bound );
 }
 
-} // detail
-
-template<typename T>
-inline void CompressedRawBinaryAppendedWriter::writeData( std::ostream&,
-                                                          const std::vector<T>& data )
+inline size_t ZlibCompressor::compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity )
 {
-  std::vector<std::vector<Byte>> compressedBlocks;
-
-  auto header = detail::zlibCompressData( data, compressedBlocks );
+  int errorCode = deflateReset( &stream );
 
-  offset += sizeof( HeaderType ) * header.size( );
+  stream.next_in = const_cast<Byte*>( source );
+  stream.avail_in = static_cast<uInt>( numberOfBytes );
+  stream.next_out = target;
+  stream.avail_out = static_cast<uInt>( (std::min)( capacity, size_t { (std::numeric_limits<uInt>::max)( ) } ) );
 
-  for( const auto& compressedBlock : compressedBlocks )
+  if( errorCode == Z_OK )
   {
-    offset += compressedBlock.size( );
+    errorCode = deflate( &stream, Z_FINISH );
   }
 
-  appendedData.push_back( std::move( compressedBlocks ) );
-  headers.push_back( std::move( header ) );
-}
-
-inline void CompressedRawBinaryAppendedWriter::writeAppended( std::ostream& output )
-{
-  for( size_t iDataSet = 0; iDataSet < appendedData.size( ); ++iDataSet )
+  if( errorCode != Z_STREAM_END )
   {
-    const char* headerBegin = reinterpret_cast<const char*>( &headers[iDataSet][0] );
-    size_t numberOfHeaderBytes = headers[iDataSet].size( ) * sizeof( HeaderType );
-
-    for( const char* ptr = headerBegin; ptr < headerBegin + numberOfHeaderBytes; ++ptr )
-    {
-      output << *ptr;
-    }
-
-    for( const auto& compressedBlock : appendedData[iDataSet] )
-    {
-      for( auto ptr = compressedBlock.begin( ); ptr < compressedBlock.end( ); ++ptr )
-      {
-        output << *ptr;
-      }
-    } // for compressedBLock
-  } // for iDataSet
-
-  output << "\n";
-}
+    throw std::runtime_error( "Error in zlib compression (code " + std::to_string( errorCode ) + ")." );
+  }
 
-inline void CompressedRawBinaryAppendedWriter::addHeaderAttributes( StringStringMap& attributes )
-{
-  attributes["header_type"] = dataTypeString<HeaderType>( );
-  attributes["compressor"] = "vtkZLibDataCompressor";
+  return stream.total_out;
 }
 
-inline void CompressedRawBinaryAppendedWriter::addDataAttributes( StringStringMap& attributes )
+namespace detail
 {
-  attributes["format"] = "appended";
-  attributes["offset"] = std::to_string( offset );
-}
 
-inline StringStringMap CompressedRawBinaryAppendedWriter::appendedAttributes( )
+template<typename T>
+std::vector<HeaderType> zlibCompressData( const std::vector<T>& data,
+                                          std::vector<Byte>& arena,
+                                          size_t blockSize = 32768, // 2^15
+                                          size_t numberOfThreads = 1,
+                                          int compressionLevel = Z_DEFAULT_COMPRESSION )
 {
-  return { { "encoding", "raw" } };
+  return compressData<ZlibCompressor>( data, arena, blockSize, numberOfThreads, compressionLevel );
 }
 
+} // detail
 } // namespace vtu11
 
 #endif // VTU11_ENABLE_ZLIB
@@ -10,9 +10,11 @@
 #ifndef VTU11_ALIAS_HPP
 #define VTU11_ALIAS_HPP
 
+#include <climits>
 #include <cstdint>
 #include <string>
 #include <map>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -26,7 +28,54 @@ enum class DataSetType : int
     PointData = 0, CellData = 1
 };
 
-using DataSetInfo = std::tuple<std::string, DataSetType, size_t>;
+//! Settings for writing a single data array that override the writer settings
+struct DataArrayOptions
+{
+    static constexpr int WriterCompressionLevel = INT_MIN;
+
+    /*! Compressed writers write this data array with stored blocks if false,
+     *  since the compressor attribute of vtk files applies to all data arrays.
+     */
+    bool compress = true;
+
+    //! Compression level for compressed writers instead of the writer's level
+    int compressionLevel = WriterCompressionLevel;
+
+    //! Keep the compressed data in the writer session, if any (set for mesh arrays)
+    bool cache = false;
+
+    static constexpr int WriterAsciiPrecision = 0;
+    static constexpr int AsciiRoundTrip = -1;
+
+    /*! Significant digits (1 to 17) of floating point values written by the 
+     *  ascii writer instead of its precision policy, or AsciiRoundTrip.
+     */
+    int asciiPrecision = WriterAsciiPrecision;
+
+    /*! Writes double values as Float32 and 64 bit integers as Int32 (or UInt32),
+     *  converting them while encoding. Throws if a value is out of range.
+     */
+    bool narrow = false;
+};
+
+//! Name, type and number of components, optionally followed by DataArrayOptions
+struct DataSetInfo : std::tuple<std::string, DataSetType, size_t>
+{
+    using std::tuple<std::string, DataSetType, size_t>::tuple;
+
+    DataSetInfo( ) = default;
+
+    DataSetInfo( const std::string& name,
+                 DataSetType type,
+                 size_t numberOfComponents,
+                 const DataArrayOptions& dataArrayOptions ) :
+      std::tuple<std::string, DataSetType, size_t>( name, type, numberOfComponents ),
+      options( dataArrayOptions )
+    { }
+
+    DataArrayOptions options;
+};
+
 using DataSetData = std::vector<double>;
 
 using VtkCellType = std::int8_t;
@@ -37,6 +86,18 @@ using Byte = unsigned char;
 
 } // namespace vtu11
 
+// DataSetInfo is used like the tuple it derives from, e.g. with structured bindings
+namespace std
+{
+
+template<>
+struct tuple_size<vtu11::DataSetInfo> : tuple_size<tuple<string, vtu11::DataSetType, size_t>> { };
+
+template<size_t Index>
+struct tuple_element<Index, vtu11::DataSetInfo> : tuple_element<Index, tuple<string, vtu11::DataSetType, size_t>> { };
+
+} // namespace std
+
 #ifndef VTU11_ASCII_FLOATING_POINT_FORMAT
     #define VTU11_ASCII_FLOATING_POINT_FORMAT "%.6g"
 #endif
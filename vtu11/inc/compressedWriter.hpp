@@ -0,0 +1,392 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_COMPRESSEDWRITER_HPP
+#define VTU11_COMPRESSEDWRITER_HPP
+
+#include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/utilities.hpp"
+
+#include <map>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace vtu11
+{
+
+struct CompressionStatistics
+{
+  size_t numberOfBytes;
+  size_t compressedNumberOfBytes;
+
+  //! Ratio of compressed and uncompressed size of the sample blocks, negative if not sampled
+  double estimatedRatio;
+
+  int compressionLevel;
+
+  //! Whether the compressed data was taken from the writer session
+  bool cached;
+};
+
+/*! Keeps the compressed data arrays that have DataArrayOptions::cache set 
+ *  (e.g. the mesh arrays) across multiple files, for example to write the 
+ *  time steps of a static mesh. Assign a session to each writer instance to
+ *  reuse the compressed data of arrays with the same address, size, block 
+ *  size, compression level and version. Entries belong to the position of 
+ *  the array among the cached arrays of the file, so adding or removing 
+ *  (uncached) fields does not affect them. They are replaced if any of these
+ *  change, so the session keeps at most one compressed copy per array. Use
+ *  a separate session for each partition, since partitions sharing one 
+ *  replace each other's entries. The level chosen by adaptive compression 
+ *  is kept with the entry, so cached arrays are not sampled again.
+ */
+template<typename Compressor>
+struct BasicWriterSession
+{
+  static constexpr std::uint64_t ContentHash = ~std::uint64_t { 0 };
+
+  /*! Identifies the content of the cached arrays. Change it whenever they 
+   *  change. By default (ContentHash) the arrays are hashed for each file, 
+   *  which is much cheaper than compressing them, but still reads them.
+   */
+  std::uint64_t version = ContentHash;
+
+  // Address, number of bytes, block size, configured level and number of adaptive sample blocks
+  using Key = std::tuple<const Byte*, size_t, size_t, int, size_t>;
+
+  //! Also keeps the selected level, such that hits do not sample the data again
+  struct Entry
+  {
+    Key key;
+    std::uint64_t version;
+    std::vector<HeaderType> header;
+    std::vector<Byte> compressedData;
+    int level;
+    double estimatedRatio;
+  };
+
+  //! Latest entry for each position of a cached data array in the file
+  std::map<size_t, Entry> entries;
+
+  size_t numberOfHits = 0;
+  size_t numberOfMisses = 0;
+
+  //! Uncompressed size of the arrays in entries
+  size_t numberOfCachedBytes( ) const;
+};
+
+/*! Settings shared by the compressed writers, which compress each data set 
+ *  in independent blocks preceded by the vtk compression header. Compressing 
+ *  a single block is delegated to the Compressor type, selected at compile 
+ *  time (e.g. ZlibCompressor, LibdeflateCompressor or a user-provided type), 
+ *  which must provide:
+ *
+ *  - static const char* name( ): the vtk compressor name (e.g. vtkZLibDataCompressor)
+ *  - static constexpr int defaultLevel: the default compression level
+ *  - static constexpr int fastLevel: a fast level for poorly compressible data
+ *  - static constexpr int storeLevel: the level closest to no compression
+ *  - Compressor( int compressionLevel ): one instance is created per thread
+ *  - static size_t compressBound( size_t numberOfBytes ): maximum compressed size
+ *  - size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, 
+ *                     size_t capacity ): compresses one block, returns its size
+ */
+template<typename Compressor>
+struct CompressionSettings
+{
+  static_assert( std::is_constructible<Compressor, int>::value, 
+                 "Compressor must be constructible from the compression level." );
+
+  static_assert( std::is_same<decltype( Compressor::compressBound( size_t { } ) ), size_t>::value, 
+                 "Compressor must provide static size_t compressBound( size_t )." );
+
+  static_assert( std::is_same<decltype( std::declval<Compressor&>( ).compress( std::declval<const Byte*>( ), 
+                 size_t { }, std::declval<Byte*>( ), size_t { } ) ), size_t>::value, 
+                 "Compressor must provide size_t compress( const Byte*, size_t, Byte*, size_t )." );
+
+  //! Appends the compressed blocks of data (as Target values) to arena, adds their statistics and returns the vtk compression header
+  template<typename Target, typename T>
+  std::vector<HeaderType> compress( const std::vector<T>& data,
+                                    std::vector<Byte>& arena );
+
+  //! Returns blockSize, or the automatic block size for numberOfBytes if blockSize is AutomaticBlockSize
+  size_t resolveBlockSize( size_t numberOfBytes ) const;
+
+  //! Returns the level used for data sets with options, unless adaptive compression samples them (timeBudgetLevel: whether a selected time budget level applies)
+  int configuredLevel( const DataArrayOptions& options, bool timeBudgetLevel = true ) const;
+
+  //! Returns the number of blocks adaptive compression samples to select the level (zero: none)
+  size_t adaptiveSampleBlocks( const detail::ArrayBytes& data, size_t resolvedBlockSize,
+                               const DataArrayOptions& options, bool timeBudgetLevel = true ) const;
+
+  //! Returns the level for compressing data, sets estimatedRatio (see CompressionStatistics)
+  int selectLevel( const detail::ArrayBytes& data, size_t resolvedBlockSize,
+                   const DataArrayOptions& options, double& estimatedRatio ) const;
+
+  //! Applies to the data written next (called before addDataAttributes)
+  void setDataArrayOptions( const DataArrayOptions& options );
+
+  //! Sets the uncompressed size of all data sets in the next file, resets the time budget level, cachedArrayIndex and statistics
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
+  //! Measures the candidate levels on the first blocks of data and sets the time budget level, without counting cachedNumberOfBytes
+  void selectTimeBudgetLevel( const detail::ArrayBytes& data, size_t resolvedBlockSize, size_t cachedNumberOfBytes = 0 );
+
+  //! Number of threads compressing blocks in parallel (0: one per hardware thread)
+  size_t numberOfThreads = 1;
+
+  //! Meaning depends on the compressor, e.g. 0 (no compression) to 9 for zlib
+  int compressionLevel = Compressor::defaultLevel;
+
+  //! Uncompressed size of compressed blocks in bytes (AutomaticBlockSize: see detail::automaticBlockSize)
+  size_t blockSize = 32768;
+
+  static constexpr size_t AutomaticBlockSize = 0;
+
+  /*! Compresses a few sample blocks of each data set first and estimates 
+   *  the compression ratio (compressed / uncompressed size) from them. Poorly
+   *  compressible data is then compressed with a faster level and nearly 
+   *  incompressible data (e.g. noise) with Compressor::storeLevel, which means
+   *  stored blocks for zlib. The compressor attribute of vtk files applies to 
+   *  all data sets, so they can not be written uncompressed individually.
+   */
+  struct AdaptiveCompression
+  {
+    bool enabled = false;
+
+    //! Data sets with less blocks than this are not sampled
+    size_t numberOfSampleBlocks = 4;
+
+    //! Use reducedLevel if the estimated ratio is above this
+    double reduceLevelRatio = 0.8;
+    int reducedLevel = Compressor::fastLevel;
+
+    //! Use Compressor::storeLevel if the estimated ratio is above this
+    double storeRatio = 0.95;
+  };
+
+  AdaptiveCompression adaptiveCompression;
+
+  /*! Chooses one compression level for the whole file, such that compressing 
+   *  and writing all data sets is estimated to finish within the given time. 
+   *  The candidate levels are tried from best to fastest by compressing the 
+   *  first blocks of the first data set, until the estimate fits the budget. 
+   *  If none does, the last (fastest) one is used, which by default is 
+   *  Compressor::storeLevel (stored blocks for zlib). The time budget takes
+   *  precedence over adaptive compression, but not over DataArrayOptions.
+   *  With a writer session, the arrays cached in the previous file are 
+   *  expected to be taken from the session again and are not counted. Arrays
+   *  taken from the session keep the level they were compressed with, so 
+   *  a different time budget level does not invalidate them.
+   */
+  struct TimeBudget
+  {
+    //! Disabled if not positive
+    double seconds = 0.0;
+
+    //! Expected bandwidth of the output in bytes per second
+    double writeBandwidth = 200e6;
+
+    size_t numberOfSampleBlocks = 4;
+
+    //! From best to fastest, empty: compressionLevel, Compressor::fastLevel and Compressor::storeLevel
+    std::vector<int> levels;
+
+    //! Set by writeVtu, zero: the size of the data set that is measured
+    size_t totalNumberOfBytes = 0;
+
+    //! Results: chosen level, its estimated time for the whole file and the uncompressed size this accounts for
+    bool selected = false;
+    int level = 0;
+    double estimatedSeconds = 0.0;
+    size_t estimatedNumberOfBytes = 0;
+  };
+
+  TimeBudget timeBudget;
+
+  //! One entry per written data set of the current file in the order of writing
+  std::vector<CompressionStatistics> statistics;
+
+  //! Options of the current data set
+  DataArrayOptions dataArrayOptions;
+
+  //! Optional cache across files, not used by the streaming writer
+  BasicWriterSession<Compressor>* session = nullptr;
+
+  //! Position of the next cached data array among the cached arrays of the current file, identifies its session entry
+  size_t cachedArrayIndex = 0;
+};
+
+//! Writes the compressed blocks as raw binary appended data
+template<typename Compressor>
+struct BasicCompressedRawBinaryAppendedWriter : CompressionSettings<Compressor>
+{
+  template<typename T>
+  void writeData( std::ostream& output,
+                  const std::vector<T>& data );
+
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
+  void writeAppended( std::ostream& output );
+
+  void addHeaderAttributes( StringStringMap& attributes );
+  void addDataAttributes( StringStringMap& attributes );
+
+  StringStringMap appendedAttributes( );
+
+  //! Also discards the appended data of the previous file, such that the writer can be reused
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
+  /*! Pads the appended data with zeros, such that the compression header of
+   *  each array starts at a multiple of alignment bytes (the compressed size 
+   *  and hence the header size are not known when the offset is written).
+   */
+  size_t alignment = 1;
+
+  size_t offset = 0;
+
+  //! Compressed blocks of all data sets, the span (begin, size) of each data set and its header
+  std::vector<Byte> arena;
+  std::vector<std::pair<size_t, size_t>> spans;
+  std::vector<std::vector<HeaderType>> headers;
+};
+
+/*! Writes the compressed blocks inline as base64 (valid xml). Like vtk, the
+ *  header and the compressed blocks are encoded as two separate streams.
+ */
+template<typename Compressor>
+struct BasicCompressedBase64Writer : CompressionSettings<Compressor>
+{
+  template<typename T>
+  void writeData( std::ostream& output,
+                  const std::vector<T>& data );
+
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
+  void writeAppended( std::ostream& output );
+
+  void addHeaderAttributes( StringStringMap& attributes );
+  void addDataAttributes( StringStringMap& attributes );
+
+  StringStringMap appendedAttributes( );
+
+  //! Compressed blocks of the current data set, reused for all data sets
+  std::vector<Byte> arena;
+};
+
+//! Same as BasicCompressedBase64Writer, but in the appended data section
+template<typename Compressor>
+struct BasicCompressedBase64AppendedWriter : CompressionSettings<Compressor>
+{
+  template<typename T>
+  void writeData( std::ostream& output,
+                  const std::vector<T>& data );
+
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
+  void writeAppended( std::ostream& output );
+
+  void addHeaderAttributes( StringStringMap& attributes );
+  void addDataAttributes( StringStringMap& attributes );
+
+  StringStringMap appendedAttributes( );
+
+  //! Also discards the appended data of the previous file, such that the writer can be reused
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
+  size_t offset = 0;
+
+  //! Compressed blocks of all data sets, the span (begin, size) of each data set and its header
+  std::vector<Byte> arena;
+  std::vector<std::pair<size_t, size_t>> spans;
+  std::vector<std::vector<HeaderType>> headers;
+};
+
+/*! Raw binary appended writer that keeps only a few compressed blocks in memory.
+ *  The xml part is written with fixed-width placeholder offsets. Then each data
+ *  set is compressed in batches of blocks that are written as soon as they are 
+ *  ready, and the block sizes and offsets are patched by seeking back. Requires
+ *  a seekable output stream and that the data stays valid until writeAppended.
+ *  Produces the same appended data as BasicCompressedRawBinaryAppendedWriter.
+ */
+template<typename Compressor>
+struct BasicStreamingCompressedRawBinaryAppendedWriter : CompressionSettings<Compressor>
+{
+  template<typename T>
+  void writeData( std::ostream& output,
+                  const std::vector<T>& data );
+
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
+  void writeAppended( std::ostream& output );
+
+  void addHeaderAttributes( StringStringMap& attributes );
+  void addDataAttributes( StringStringMap& attributes );
+
+  StringStringMap appendedAttributes( );
+
+  //! Also discards the appended data of the previous file, such that the writer can be reused
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
+  //! Stream position of the offset placeholder of the next data set, recorded while writing its tag
+  void setOffsetPosition( std::streamoff position );
+
+  //! Number of digits of the zero-padded offsets (enough for any 64 bit value)
+  static constexpr size_t OffsetWidth = 20;
+
+  //! Number of blocks compressed per thread before writing them
+  static constexpr size_t BlocksPerThread = 16;
+
+  /*! Compress the next batches of blocks in a separate thread, while the 
+   *  calling thread writes the current one. Then compression and writing to 
+   *  disk overlap, at the cost of one more thread and PipelineDepth + 1 
+   *  batches in memory.
+   */
+  bool pipelined = false;
+
+  //! Maximum number of compressed batches waiting to be written
+  static constexpr size_t PipelineDepth = 2;
+
+  struct Batch
+  {
+    int level;
+    double estimatedRatio;
+    std::vector<HeaderType> header;
+    std::vector<Byte> arena;
+  };
+
+  struct DataSet
+  {
+    detail::ArrayBytes array;
+    std::streamoff offsetPosition;
+    DataArrayOptions options;
+  };
+
+  //! Same as in BasicCompressedRawBinaryAppendedWriter
+  size_t alignment = 1;
+
+  std::streamoff offsetPosition = -1;
+
+  std::vector<DataSet> appendedData;
+};
+
+} // namespace vtu11
+
+#include "vtu11/impl/compressedWriter_impl.hpp"
+
+#endif // VTU11_COMPRESSEDWRITER_HPP
@@ -0,0 +1,63 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LIBDEFLATEWRITER_HPP
+#define VTU11_LIBDEFLATEWRITER_HPP
+
+#include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/compressedWriter.hpp"
+
+#ifdef VTU11_ENABLE_LIBDEFLATE
+
+#include "libdeflate.h"
+
+namespace vtu11
+{
+
+/*! Whole buffer zlib compression with libdeflate, which is considerably faster 
+ *  than zlib. The output is in zlib format and read by the same vtk compressor.
+ */
+class LibdeflateCompressor final
+{
+public:
+  static const char* name( ) { return "vtkZLibDataCompressor"; }
+
+  //! From 0 (no compression) and 1 (fastest) to 12 (best compression)
+  static constexpr int defaultLevel = 6;
+  static constexpr int fastLevel = 1;
+  static constexpr int storeLevel = 0;
+
+  explicit LibdeflateCompressor( int compressionLevel );
+
+  LibdeflateCompressor( const LibdeflateCompressor& ) = delete;
+  LibdeflateCompressor& operator=( const LibdeflateCompressor& ) = delete;
+
+  ~LibdeflateCompressor( );
+
+  static size_t compressBound( size_t numberOfBytes );
+
+  size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity );
+
+private:
+  libdeflate_compressor* compressor;
+};
+
+using LibdeflateCompressedRawBinaryAppendedWriter = BasicCompressedRawBinaryAppendedWriter<LibdeflateCompressor>;
+using LibdeflateCompressedBase64Writer = BasicCompressedBase64Writer<LibdeflateCompressor>;
+using LibdeflateCompressedBase64AppendedWriter = BasicCompressedBase64AppendedWriter<LibdeflateCompressor>;
+using LibdeflateStreamingCompressedRawBinaryAppendedWriter = BasicStreamingCompressedRawBinaryAppendedWriter<LibdeflateCompressor>;
+using LibdeflateWriterSession = BasicWriterSession<LibdeflateCompressor>;
+
+} // namespace vtu11
+
+#include "vtu11/impl/libdeflateWriter_impl.hpp"
+
+#endif // VTU11_ENABLE_LIBDEFLATE
+
+#endif // VTU11_LIBDEFLATEWRITER_HPP
@@ -0,0 +1,60 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LZ4WRITER_HPP
+#define VTU11_LZ4WRITER_HPP
+
+#include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/compressedWriter.hpp"
+
+#ifdef VTU11_ENABLE_LZ4
+
+#include "lz4.h"
+
+namespace vtu11
+{
+
+//! LZ4 block compression using one preallocated compression state
+class Lz4Compressor final
+{
+public:
+  static const char* name( ) { return "vtkLZ4DataCompressor"; }
+
+  //! From 1 (fastest) to 9 (best compression), mapped to an acceleration of 10 - level as in vtk
+  static constexpr int defaultLevel = 9;
+  static constexpr int fastLevel = 1;
+
+  //! LZ4 has no stored mode, but its fastest level quickly gives up on incompressible data
+  static constexpr int storeLevel = 1;
+
+  explicit Lz4Compressor( int compressionLevel );
+
+  static size_t compressBound( size_t numberOfBytes );
+
+  size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity );
+
+private:
+  int acceleration;
+
+  std::vector<char> state;
+};
+
+using Lz4CompressedRawBinaryAppendedWriter = BasicCompressedRawBinaryAppendedWriter<Lz4Compressor>;
+using Lz4CompressedBase64Writer = BasicCompressedBase64Writer<Lz4Compressor>;
+using Lz4CompressedBase64AppendedWriter = BasicCompressedBase64AppendedWriter<Lz4Compressor>;
+using Lz4StreamingCompressedRawBinaryAppendedWriter = BasicStreamingCompressedRawBinaryAppendedWriter<Lz4Compressor>;
+using Lz4WriterSession = BasicWriterSession<Lz4Compressor>;
+
+} // namespace vtu11
+
+#include "vtu11/impl/lz4Writer_impl.hpp"
+
+#endif // VTU11_ENABLE_LZ4
+
+#endif // VTU11_LZ4WRITER_HPP
@@ -0,0 +1,65 @@
+//          __        ____ ____
+// ___  ___/  |_ __ _/_   /_   |
+// \  \/ /\   __\  |  \   ||   |
+//  \   /  |  | |  |  /   ||   |
+//   \_/   |__| |____/|___||___|
+//
+//  License: BSD License ; see LICENSE
+//
+
+#ifndef VTU11_LZMAWRITER_HPP
+#define VTU11_LZMAWRITER_HPP
+
+#include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/compressedWriter.hpp"
+
+#ifdef VTU11_ENABLE_LZMA
+
+#include "lzma.h"
+
+namespace vtu11
+{
+
+//! Xz stream encoder that is initialized once and then reused for each block
+class LzmaCompressor final
+{
+public:
+  static const char* name( ) { return "vtkLZMADataCompressor"; }
+
+  //! Preset from 0 (fastest) to 9 (best compression)
+  static constexpr int defaultLevel = 6;
+  static constexpr int fastLevel = 0;
+
+  //! LZMA has no stored mode, use the fastest preset
+  static constexpr int storeLevel = 0;
+
+  explicit LzmaCompressor( int compressionLevel );
+
+  LzmaCompressor( const LzmaCompressor& ) = delete;
+  LzmaCompressor& operator=( const LzmaCompressor& ) = delete;
+
+  ~LzmaCompressor( );
+
+  static size_t compressBound( size_t numberOfBytes );
+
+  size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity );
+
+private:
+  std::uint32_t preset;
+
+  lzma_stream stream;
+};
+
+using LzmaCompressedRawBinaryAppendedWriter = BasicCompressedRawBinaryAppendedWriter<LzmaCompressor>;
+using LzmaCompressedBase64Writer = BasicCompressedBase64Writer<LzmaCompressor>;
+using LzmaCompressedBase64AppendedWriter = BasicCompressedBase64AppendedWriter<LzmaCompressor>;
+using LzmaStreamingCompressedRawBinaryAppendedWriter = BasicStreamingCompressedRawBinaryAppendedWriter<LzmaCompressor>;
+using LzmaWriterSession = BasicWriterSession<LzmaCompressor>;
+
+} // namespace vtu11
+
+#include "vtu11/impl/lzmaWriter_impl.hpp"
+
+#endif // VTU11_ENABLE_LZMA
+
+#endif // VTU11_LZMAWRITER_HPP
@@ -12,8 +12,11 @@
 
 #include "vtu11/inc/alias.hpp"
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <limits>
+#include <mutex>
 #include <type_traits>
 
 namespace vtu11
@@ -24,11 +27,132 @@ namespace vtu11
 
 std::string endianness( );
 
+//! Iterators must refer to contiguous memory (e.g. pointers or std::vector iterators)
 template<typename Iterator>
 std::string base64Encode( Iterator begin, Iterator end );
 
 size_t encodedNumberOfBytes( size_t rawNumberOfBytes );
 
+namespace detail
+{
+
+/*! Instruction set levels of the base64 encoding kernels. The best one
+ *  supported by the executing cpu is selected at runtime. Defining
+ *  VTU11_DISABLE_SIMD restricts the selection to the scalar version.
+ */
+enum class Base64Isa : int
+{
+    Scalar = 0, SSSE3 = 1, AVX2 = 2, AVX512 = 3
+};
+
+//! Encodes a prefix of complete triplets and returns the number of bytes consumed
+using Base64Kernel = size_t( * )( const Byte* source, size_t numberOfBytes, char* target );
+
+bool base64IsaSupported( Base64Isa isa );
+Base64Isa base64BestIsa( );
+Base64Kernel base64Kernel( Base64Isa isa );
+
+//! Encodes all complete triplets of source and returns the number of bytes consumed
+size_t base64EncodeTriplets( const Byte* source, size_t numberOfBytes, char* target );
+
+//! Encodes all bytes including padding into encodedNumberOfBytes( numberOfBytes ) chars
+void base64EncodeBytes( const Byte* source, size_t numberOfBytes, char* target );
+
+//! Returns the number of hardware threads if numberOfThreads is zero
+size_t resolveNumberOfThreads( size_t numberOfThreads );
+
+//! Calls function concurrently from numberOfThreads threads (including the calling one)
+template<typename Function>
+void runInParallel( size_t numberOfThreads, Function&& function );
+
+//! Writes numberOfBytes zero bytes
+void writeZeros( std::ostream& output, size_t numberOfBytes );
+
+//! Smallest offset not below offset, such that offset + headerSize is a multiple of alignment
+size_t alignOffset( size_t offset, size_t headerSize, size_t alignment );
+
+//! Copies numberOfBytes bytes starting at firstByte of the converted values at data to target
+using ConvertFunction = void( * )( const Byte* data, size_t firstByte, size_t numberOfBytes, Byte* target );
+
+/*! Bytes of a data array as written to the file. If convert is set, the values
+ *  at data are converted while writing (e.g. from double to float), in chunks
+ *  instead of converting the whole array at once.
+ */
+struct ArrayBytes
+{
+    const Byte* data;
+    size_t numberOfBytes;
+    ConvertFunction convert;
+
+    //! Returns the bytes [begin, begin + size), converted into buffer if convert is set
+    const Byte* bytes( size_t begin, size_t size, Byte* buffer ) const;
+};
+
+//! Bytes of data written as Target values
+template<typename Target, typename T>
+ArrayBytes arrayBytes( const std::vector<T>& data );
+
+//! Calls function( const Byte* chunk, size_t size ) for consecutive chunks of array
+template<typename Function>
+void forEachChunk( const ArrayBytes& array, Function&& function );
+
+//! Type written for T with DataArrayOptions::narrow: float for double, 32 bit for 64 bit integers
+template<typename T> struct NarrowedType { using type = T; };
+template<> struct NarrowedType<double> { using type = float; };
+template<> struct NarrowedType<std::int64_t> { using type = std::int32_t; };
+template<> struct NarrowedType<std::uint64_t> { using type = std::uint32_t; };
+
+//! Queue for passing values between threads, push blocks while the queue is full
+template<typename T>
+class BoundedQueue final
+{
+public:
+    explicit BoundedQueue( size_t capacity );
+
+    //! Returns false if the queue was closed
+    bool push( T value );
+
+    //! Blocks until a value is available, returns false if the queue is empty and closed
+    bool pop( T& value );
+
+    //! Wakes up all waiting threads, following push calls fail
+    void close( );
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_, notEmpty_;
+    std::deque<T> values_;
+    size_t capacity_;
+    bool closed_;
+};
+
+} // namespace detail
+
+/*! Base64 encodes the bytes of consecutive write calls as one continuous stream.
+ *  Incomplete triplets are carried over to the next call and the encoded chars
+ *  are written to output in chunks, so memory usage does not depend on the
+ *  number of bytes encoded. Call finish( ) to write the padded end.
+ */
+class Base64Encoder final
+{
+public:
+    explicit Base64Encoder( std::ostream& output, size_t chunkSize = 64 * 1024 );
+
+    void write( const void* data, size_t numberOfBytes );
+
+    void finish( );
+
+private:
+    void flush( );
+
+    std::ostream& output_;
+    std::vector<char> buffer_;
+    size_t size_;
+
+    Byte carry_[3];
+    size_t carrySize_;
+};
+
 class ScopedXmlTag final
 {
 public:
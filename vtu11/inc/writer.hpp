@@ -11,31 +11,111 @@
 #define VTU11_WRITER_HPP
 
 #include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/utilities.hpp"
+#include "vtu11/inc/compressedWriter.hpp"
 #include "vtu11/inc/zlibWriter.hpp"
+#include "vtu11/inc/lz4Writer.hpp"
+#include "vtu11/inc/lzmaWriter.hpp"
+#include "vtu11/inc/libdeflateWriter.hpp"
 
 namespace vtu11
 {
 
-struct AsciiWriter
+/*! Precision policies for floating point values in ascii files. They format
+ *  one value into at most 64 chars and return the number of chars written.
+ */
+
+//! Formats with VTU11_ASCII_FLOATING_POINT_FORMAT
+class FormatStringPrecision
+{
+public:
+  FormatStringPrecision( );
+
+  size_t operator( )( char* target, double value ) const;
+
+private:
+  // Significant digits if the format is "%.<n>g", otherwise -1
+  int digits_;
+};
+
+//! Formats with the given number of significant digits, like "%.<Digits>g"
+template<int Digits>
+struct SignificantDigits
+{
+  static_assert( Digits >= 1 && Digits <= 17, "Number of significant digits must be between 1 and 17." );
+
+  size_t operator( )( char* target, double value ) const;
+};
+
+/*! Formats with as many digits as needed to read back the exact same value: 
+ *  the shortest such representation with std::to_chars (C++17), otherwise 
+ *  at most 17 significant digits.
+ */
+struct RoundTripPrecision
+{
+  size_t operator( )( char* target, double value ) const;
+
+  //! Float values (e.g. narrowed with DataArrayOptions::narrow) read back as float
+  size_t operator( )( char* target, float value ) const;
+};
+
+/*! The precision policy applies to all floating point data arrays, unless 
+ *  DataArrayOptions::asciiPrecision selects a different one for an array.
+ */
+template<typename Precision>
+struct BasicAsciiWriter
 {
   template<typename T>
   void writeData( std::ostream& output,
                   const std::vector<T>& data );
 
+  //! Same as writeData, but converts the values to Target (e.g. float) while writing them
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
   void writeAppended( std::ostream& output );
 
   void addHeaderAttributes( StringStringMap& attributes );
   void addDataAttributes( StringStringMap& attributes );
 
   StringStringMap appendedAttributes( );
+
+  //! Applies to the data written next (called before addDataAttributes)
+  void setDataArrayOptions( const DataArrayOptions& options );
+
+  //! Writes data as Target values formatted by the given policy (instead of precision)
+  template<typename Target, typename T, typename ArrayPrecision>
+  void writeFormatted( std::ostream& output,
+                       const std::vector<T>& data,
+                       const ArrayPrecision& arrayPrecision );
+
+  Precision precision;
+
+  //! Number of threads formatting chunks of values in parallel (0: one per hardware thread)
+  size_t numberOfThreads = 1;
+
+  //! Number of values per chunk and number of chunks formatted per thread before writing them
+  static constexpr size_t ChunkSize = 16384;
+  static constexpr size_t ChunksPerThread = 4;
+
+  //! Options of the current data set
+  DataArrayOptions dataArrayOptions;
 };
 
+using AsciiWriter = BasicAsciiWriter<FormatStringPrecision>;
+using RoundTripAsciiWriter = BasicAsciiWriter<RoundTripPrecision>;
+
 struct Base64BinaryWriter
 {
   template<typename T>
   void writeData( std::ostream& output,
                   const std::vector<T>& data );
 
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
   void writeAppended( std::ostream& output );
 
   void addHeaderAttributes( StringStringMap& attributes );
@@ -50,6 +130,10 @@ struct Base64BinaryAppendedWriter
   void writeData( std::ostream& output,
                   const std::vector<T>& data );
 
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
   void writeAppended( std::ostream& output );
 
   void addHeaderAttributes( StringStringMap& attributes );
@@ -57,9 +141,12 @@ struct Base64BinaryAppendedWriter
 
   StringStringMap appendedAttributes( );
 
+  //! Discards the appended data of the previous file, such that the writer can be reused
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
   size_t offset = 0;
 
-  std::vector<std::pair<const char*, HeaderType>> appendedData;
+  std::vector<detail::ArrayBytes> appendedData;
 };
 
 struct RawBinaryAppendedWriter
@@ -68,6 +155,10 @@ struct RawBinaryAppendedWriter
   void writeData( std::ostream& output,
                   const std::vector<T>& data );
 
+  template<typename Target, typename T>
+  void writeConverted( std::ostream& output,
+                       const std::vector<T>& data );
+
   void writeAppended( std::ostream& output );
 
   void addHeaderAttributes( StringStringMap& attributes );
@@ -75,9 +166,33 @@ struct RawBinaryAppendedWriter
 
   StringStringMap appendedAttributes( );
 
+  //! Discards the appended data of the previous file, such that the writer can be reused
+  void setTotalNumberOfBytes( size_t numberOfBytes );
+
+  /*! Same as writeAppended( output ), where output writes to filename and is 
+   *  positioned after the '_'. With more than one thread on POSIX systems, the
+   *  file is resized to the end of the appended data and the headers and 
+   *  chunks of the arrays are written concurrently using pwrite. Parallel file 
+   *  systems often need several outstanding writes to reach full bandwidth.
+   */
+  void writeAppended( std::ostream& output, const std::string& filename );
+
+  //! Number of threads writing the appended data (0 for one per hardware thread)
+  size_t numberOfThreads = 1;
+
+  //! Maximum number of bytes per pwrite call
+  size_t chunkSize = 4 * 1024 * 1024;
+
+  /*! Pads the appended data with zeros, such that the data of each array 
+   *  (after its header) starts at a multiple of alignment bytes, e.g. 64 or 
+   *  4096 for reading memory mapped files in place. writeVtu also aligns the
+   *  start of the appended data in the file. One means no padding.
+   */
+  size_t alignment = 1;
+
   size_t offset = 0;
 
-  std::vector<std::pair<const char*, HeaderType>> appendedData;
+  std::vector<detail::ArrayBytes> appendedData;
 };
 
 } // namespace vtu11
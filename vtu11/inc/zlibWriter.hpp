@@ -11,31 +11,50 @@
 #define VTU11_ZLIBWRITER_HPP
 
 #include "vtu11/inc/alias.hpp"
+#include "vtu11/inc/compressedWriter.hpp"
 
 #ifdef VTU11_ENABLE_ZLIB
 
+#include "zlib.h"
+
 namespace vtu11
 {
 
-struct CompressedRawBinaryAppendedWriter
+//! Deflate stream that is initialized once and then reset for each block
+class ZlibCompressor final
 {
-  template<typename T>
-  void writeData( std::ostream& output,
-                  const std::vector<T>& data );
+public:
+  static const char* name( ) { return "vtkZLibDataCompressor"; }
+
+  //! From Z_NO_COMPRESSION (0) and Z_BEST_SPEED (1) to Z_BEST_COMPRESSION (9)
+  static constexpr int defaultLevel = Z_DEFAULT_COMPRESSION;
+  static constexpr int fastLevel = Z_BEST_SPEED;
+
+  //! Writes stored blocks (no compression, only five bytes overhead per 64 KiB)
+  static constexpr int storeLevel = Z_NO_COMPRESSION;
 
-  void writeAppended( std::ostream& output );
+  explicit ZlibCompressor( int compressionLevel );
 
-  void addHeaderAttributes( StringStringMap& attributes );
-  void addDataAttributes( StringStringMap& attributes );
+  ZlibCompressor( const ZlibCompressor& ) = delete;
+  ZlibCompressor& operator=( const ZlibCompressor& ) = delete;
 
-  StringStringMap appendedAttributes( );
+  ~ZlibCompressor( );
 
-  size_t offset = 0;
+  static size_t compressBound( size_t numberOfBytes );
 
-  std::vector<std::vector<std::vector<std::uint8_t>>> appendedData;
-  std::vector<std::vector<HeaderType>> headers;
+  //! Produces the same output as zlib's compress2 with the same level
+  size_t compress( const Byte* source, size_t numberOfBytes, Byte* target, size_t capacity );
+
+private:
+  z_stream stream;
 };
 
+using CompressedRawBinaryAppendedWriter = BasicCompressedRawBinaryAppendedWriter<ZlibCompressor>;
+using CompressedBase64Writer = BasicCompressedBase64Writer<ZlibCompressor>;
+using CompressedBase64AppendedWriter = BasicCompressedBase64AppendedWriter<ZlibCompressor>;
+using StreamingCompressedRawBinaryAppendedWriter = BasicStreamingCompressedRawBinaryAppendedWriter<ZlibCompressor>;
+using WriterSession = BasicWriterSession<ZlibCompressor>;
+
 } // namespace vtu11
 
 #include "vtu11/impl/zlibWriter_impl.hpp"
@@ -13,6 +13,8 @@
 #include "vtu11/inc/alias.hpp"
 #include "vtu11/inc/writer.hpp"
 
+#include <type_traits>
+
 namespace vtu11
 {
 
@@ -37,12 +39,29 @@ struct Vtu11UnstructuredMesh
  *  - Ascii 
  *  - Base64Inline
  *  - Base64Appended
+ *  - Base64InlineCompressed
+ *  - Base64AppendedCompressed
+ *  - Base64InlineLZ4Compressed
+ *  - Base64AppendedLZ4Compressed
  *  - RawBinary
  *  - RawBinaryCompressed
+ *  - RawBinaryStreamingCompressed
+ *  - RawBinaryLZ4Compressed
+ *  - RawBinaryLZMACompressed
  *  
  *  Comments:
  *  - RawCompressedBinary needs zlib to be present. If VTU11_ENABLE_ZLIB
  *    is not defined, the uncompressed version is used instead.
+ *  - RawBinaryStreamingCompressed writes the same data as RawBinaryCompressed,
+ *    but streams the compressed blocks to the file and patches the offsets
+ *    afterwards, instead of keeping all compressed data in memory.
+ *  - The compressed base64 modes fall back to the uncompressed base64
+ *    versions in the same way. They produce valid xml like Base64Inline 
+ *    and Base64Appended, but encode the compressed blocks.
+ *  - RawBinaryLZ4Compressed needs LZ4 and VTU11_ENABLE_LZ4 to be defined,
+ *    otherwise the uncompressed version is used instead.
+ *  - RawBinaryLZMACompressed needs liblzma and VTU11_ENABLE_LZMA to be 
+ *    defined, otherwise the uncompressed version is used instead.
  *  - Compressing data takes more time than writing more data uncompressed
  *  - Ascii produces surprisingly small files, is nice to debug, but 
  *    is rather slow to read in Paraview. Archiving ascii .vtu files using
@@ -61,11 +80,23 @@ void writeVtu( const std::string& filename,
                const std::vector<DataSetData>& dataSetData,
                const std::string& writeMode = "RawBinaryCompressed" );
 
-//! Creates path/baseName.pvtu and path/baseName directory
+//! Writes single file using the given writer instance (e.g. to change its settings).
+//! The writer starts over for each file and can be reused for several files.
+template<typename MeshGenerator, typename Writer>
+typename std::enable_if<!std::is_convertible<Writer, std::string>::value>::type
+    writeVtu( const std::string& filename,
+              MeshGenerator& mesh,
+              const std::vector<DataSetInfo>& dataSetInfo,
+              const std::vector<DataSetData>& dataSetData,
+              Writer&& writer );
+
+//! Creates path/baseName.pvtu and path/baseName directory. The mesh options
+//! must match those of the pieces (e.g. to narrow the points to Float32).
 void writePVtu( const std::string& path,
                 const std::string& baseName,
                 const std::vector<DataSetInfo>& dataSetInfo,
-                size_t numberOfFiles );
+                size_t numberOfFiles,
+                const DataArrayOptions& meshOptions = DataArrayOptions { } );
 	
 //! Forwards path/baseName.vtu to the writeVtu function
 template<typename MeshGenerator>
@@ -77,6 +108,17 @@ void writePartition( const std::string& path,
                      size_t fileId,
                      const std::string& writeMode = "RawBinaryCompressed" );
 
+//! Forwards path/baseName.vtu and the given writer instance to the writeVtu function
+template<typename MeshGenerator, typename Writer>
+typename std::enable_if<!std::is_convertible<Writer, std::string>::value>::type
+    writePartition( const std::string& path,
+                    const std::string& baseName,
+                    MeshGenerator& mesh,
+                    const std::vector<DataSetInfo>& dataSetInfo,
+                    const std::vector<DataSetData>& dataSetData,
+                    size_t fileId,
+                    Writer&& writer );
+
 } // namespace vtu11
 
 #include "vtu11/impl/vtu11_impl.hpp"